@@ -0,0 +1,107 @@
+#!/usr/bin/env bash
+#
+# A/B benchmark of the oscillators against the vanilla Pd chains they replace
+# written for the various oscillators library
+#
+# Every oscillator has two voice abstractions in this directory, <name>-external.pd
+# playing the object and <name>-vanilla.pd building the same waveform out of vanilla
+# objects. For every voice count a patch with that many copies of a voice is run
+# through pd -batch, which computes the DSP as fast as it can without a sound card,
+# and the CPU time it takes, less that of the same patch without voices, is reported
+# per voice as a percentage of one core playing in real time.
+#
+#   benchmark/osc_bench.sh [-pd pd] [-voices "1 8 32 128"] [-seconds 20] [-repeat 3] [oscillator...]
+#
+# -pd is the Pd binary (Pd 0.54 or later, for -batch), -seconds the length of audio
+# rendered per run, and the fastest of -repeat runs counts. The oscillators default
+# to all of them. The objects are loaded from the directory above this one, so run
+# make there first (make bench does both).
+
+PD=pd
+VOICES="1 8 32 128"
+SECONDS_RENDERED=20
+REPEAT=3
+OSCILLATORS=
+
+while [ $# -gt 0 ]; do
+	case "$1" in
+		-pd) PD="$2"; shift 2 ;;
+		-voices) VOICES="$2"; shift 2 ;;
+		-seconds) SECONDS_RENDERED="$2"; shift 2 ;;
+		-repeat) REPEAT="$2"; shift 2 ;;
+		-*) echo "usage: $0 [-pd pd] [-voices \"1 8 32 128\"] [-seconds 20] [-repeat 3] [oscillator...]" >&2; exit 1 ;;
+		*) OSCILLATORS="$OSCILLATORS $1"; shift ;;
+	esac
+done
+[ -n "$OSCILLATORS" ] || OSCILLATORS="powSine randOsc varShapesOsc allOsc sineLoop"
+
+BENCH=$(cd "$(dirname "$0")" && pwd)
+OBJECTS=$(dirname "$BENCH")
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+if ! command -v "$PD" >/dev/null 2>&1; then
+	echo "$0: can't find $PD, give its path with -pd" >&2
+	exit 1
+fi
+
+# Writes a patch turning the DSP on, running $2 copies of the abstraction $1 for
+# SECONDS_RENDERED seconds of logical time into a [dac~], and quitting
+make_patch() {
+	local voice=$1 count=$2 i
+	{
+		echo "#N canvas 0 50 450 300 10;"
+		echo "#X obj 20 20 loadbang;"
+		echo "#X msg 20 50 \\; pd dsp 1;"
+		echo "#X obj 120 50 delay $((SECONDS_RENDERED * 1000));"
+		echo "#X msg 120 80 \\; pd quit;"
+		echo "#X obj 20 300 dac~;"
+		for((i = 0; i < count; i++)); do
+			echo "#X obj $((20 + (i % 10) * 40)) $((120 + (i / 10) * 25)) $voice;"
+		done
+		echo "#X connect 0 0 1 0;"
+		echo "#X connect 0 0 2 0;"
+		echo "#X connect 2 0 3 0;"
+		for((i = 0; i < count; i++)); do
+			echo "#X connect $((5 + i)) 0 4 0;"
+		done
+	} > "$WORK/bench.pd"
+}
+
+# Prints the fastest CPU time (user + system, in seconds) of REPEAT runs of the patch
+run_patch() {
+	local best= cpu i
+	for((i = 0; i < REPEAT; i++)); do
+		cpu=$( { TIMEFORMAT='%U %S'; time "$PD" -nogui -nosound -nomidi -batch -noprefs \
+			-path "$OBJECTS" -path "$BENCH" -open "$WORK/bench.pd" >/dev/null 2>&1; } 2>&1 |
+			awk '{ print $1 + $2 }')
+		if [ -z "$best" ] || awk "BEGIN { exit !($cpu < $best) }"; then best=$cpu; fi
+	done
+	echo "$best"
+}
+
+# the cost of starting Pd and running an empty DSP chain, taken off every run
+make_patch "" 0
+BASE=$(run_patch)
+
+printf "%s seconds of audio per run, fastest of %s runs, %% of one core per voice\n\n" "$SECONDS_RENDERED" "$REPEAT"
+printf "%-14s %7s %12s %12s %10s\n" oscillator voices external vanilla speedup
+for osc in $OSCILLATORS; do
+	if [ ! -f "$BENCH/$osc-external.pd" ]; then
+		echo "$0: no benchmark for $osc" >&2
+		continue
+	fi
+	for count in $VOICES; do
+		make_patch "$osc-external" "$count"
+		external=$(run_patch)
+		make_patch "$osc-vanilla" "$count"
+		vanilla=$(run_patch)
+		awk -v osc="$osc~" -v n="$count" -v s="$SECONDS_RENDERED" -v base="$BASE" \
+			-v e="$external" -v v="$vanilla" 'BEGIN {
+			e = (e - base) / s / n * 100; if(e < 0) e = 0
+			v = (v - base) / s / n * 100; if(v < 0) v = 0
+			printf "%-14s %7d %11.4f%% %11.4f%% ", osc, n, e, v
+			if(e > 0) printf "%9.2fx\n", v / e; else printf "%10s\n", "-"
+		}'
+	done
+done
@@ -0,0 +1,2855 @@
+/****************************************************
+ * Oscillator kernels of the various oscillators    *
+ * library, without any dependency on Pd. The Pd    *
+ * objects call these from their perform routines   *
+ ****************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <pthread.h>
+#include "various_oscillators.h"
+
+// The table cache needs mmap(), elsewhere the tables are built every time.
+// Fixed point builds have no band-limited tables, so nothing to cache
+#if !defined(_WIN32) && !defined(OSC_FIXED)
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#define OSC_CACHE
+#endif
+
+// Constant definitions
+#define POWSINE_STEPSIZE 8192
+#define RANDOSC_STEPSIZE 8192
+#define VARSHAPES_STEPSIZE 8192
+#define ALLOSC_STEPSIZE 8192
+// band-limited tables: size of each table, number of mip levels (one per octave)
+// and number of exponent buckets the power input is crossfaded between
+#define POWSINE_BL_TABSIZE 2048
+#define POWSINE_BL_LEVELS 10
+#define POWSINE_BL_BUCKETS 19
+// the same for the tables [tabOsc~] builds from arrays, the phase counts table samples
+#define TABOSC_TABBITS 11
+#define TABOSC_TABSIZE (1 << TABOSC_TABBITS)
+#define TABOSC_LEVELS 10
+// samples the separate (restrict-qualified) kernels render at a time, the
+// vectors they pass from one pass to the next are this long, on the stack
+#define OSC_CHUNK 64
+
+#define OSC_TWOPI ((osc_sample) 6.283185307179586)
+// fixed point kernels: 1 in Q2.30, a whole cycle of a Q0.32 phase as a float,
+// 1 in the Q16.16 powers and in the Q8.24 [tabOsc~]'s tables are built in
+#define FIXED_ONE (1 << 30)
+#define FIXED_CYCLE ((osc_sample) 4294967296.0)
+#define FIXED_POWER_ONE ((osc_sample) 65536.0)
+#define FIXED_FFT_ONE (1 << 24)
+
+// Math functions matching the width of osc_sample, so that double precision
+// builds keep the full precision and single precision builds don't convert
+// every sample to double and back
+#if OSC_FLOATSIZE == 64
+#define OSC_COS(x) cos(x)
+#define OSC_POW(x, y) pow((x), (y))
+#define OSC_FLOOR(x) floor(x)
+#else
+#define OSC_COS(x) cosf(x)
+#define OSC_POW(x, y) powf((x), (y))
+#define OSC_FLOOR(x) floorf(x)
+#endif
+
+// Bases of pow() below this are flushed to 0 (NaN included), so pow() never
+// takes its slow path on denormals and a bad input can't reach the output
+#define OSC_TINY ((osc_sample) 1e-15)
+#define OSC_FLUSH(x) ((x) > OSC_TINY ? (x) : 0)
+
+#ifndef OSC_FIXED
+// band-limited tables of [powSine~], shared between all instances and built by
+// osc_tables_init(), laid out as [bucket][level][POWSINE_BL_TABSIZE + 1].
+// They're only tried once, if that fails they stay null and bandlimit does nothing
+static const osc_sample *powSine_bl_tab;
+static int powSine_bl_tried;
+#define POWSINE_BL_COUNT ((POWSINE_BL_TABSIZE + 1) * POWSINE_BL_LEVELS * POWSINE_BL_BUCKETS)
+
+// Header of a table cache file, the tables follow it as they're laid out in memory.
+// A file with another version, sample size, length or checksum is built again
+#define OSC_CACHE_MAGIC 0x5443534fu // "OSCT" read on a little endian machine
+#define OSC_CACHE_VERSION 1 // bump it whenever the code building a cached table changes
+typedef struct _osc_cache_header {
+	uint32_t magic, version;
+	uint32_t samplesize; // sizeof(osc_sample)
+	uint32_t count; // number of samples
+	uint64_t checksum; // of the samples, see cache_checksum()
+	char pad[40]; // keeps the tables 64 byte aligned in the mapping
+} osc_cache_header;
+
+// the exponents each bucket of tables is rendered with
+static const osc_sample powSine_bl_powers[POWSINE_BL_BUCKETS] = {
+	0, 0.125, 0.25, 0.375, 0.5, 0.75, 1, 1.5, 2, 3, 4, 6, 8, 12, 16, 24, 32, 48, 64
+};
+#endif
+
+// The cosine table of [sineLoop~] and [sineLoopBank~], and the tables of the fixed
+// point kernels, with their sizes (SINELOOP_STEP, FIXED_COS_BITS, FIXED_LOG_BITS).
+// They're generated by osc_tablegen.c when the library is built, and compiled in
+#include "osc_tables.h"
+
+#ifndef OSC_FIXED
+static const osc_sample sineLoop_one_over_step = 1.0 / SINELOOP_STEP;
+#endif
+
+// Function prototypes
+#ifndef OSC_FIXED
+static void osc_fft(double *real, double *imag, int n, int inverse);
+static void make_bl_tabs(void);
+static uint64_t cache_checksum(const void *data, size_t bytes, uint64_t seed);
+#ifdef OSC_CACHE
+static int cache_path(char *path, int size, const char *name);
+static const osc_sample *cache_map(const char *path, uint32_t count, uint64_t seed);
+static void cache_write(const char *path, const osc_sample *tab, uint32_t count, uint64_t seed);
+static int cache_write_all(int fd, const void *data, size_t bytes);
+#endif
+static void powSine_render_separate(osc_powSine *x, const osc_sample *const *inputs, osc_sample *const *outputs, int n);
+static void powSine_render_bandlimited(osc_powSine *x, const osc_sample *const *inputs, osc_sample *const *outputs, int n);
+static void randOsc_render_separate(osc_randOsc *x, const osc_sample *const *inputs, osc_sample *const *outputs, int n);
+static void varShapesOsc_render_separate(osc_varShapesOsc *x, const osc_sample *const *inputs, osc_sample *const *outputs, int n);
+static void allOsc_render_separate(osc_allOsc *x, const osc_sample *const *inputs, osc_sample *const *outputs, int n);
+static osc_sample powSine_waveform(const osc_sample *restrict phases, const osc_sample *restrict phase_mod,
+	const osc_sample *restrict power, osc_sample *restrict out, int n);
+static void randOsc_waveform(const osc_sample *restrict phases, const osc_sample *restrict randoms,
+	const osc_sample *restrict old_randoms, const osc_sample *restrict xfade, const osc_sample *restrict power,
+	osc_sample *restrict out, int n);
+static void varShapesOsc_waveform(const osc_sample *restrict phases, const osc_sample *restrict phase_mod,
+	const osc_sample *restrict xfade, const osc_sample *restrict breakpoint, const osc_sample *restrict rise_power,
+	const osc_sample *restrict fall_power, osc_sample *restrict out, int n);
+static void allOsc_waveform(const osc_sample *restrict phases, const osc_sample *restrict phase_mod,
+	const osc_sample *restrict duty_cycle, osc_sample *restrict out1, osc_sample *restrict out2,
+	osc_sample *restrict out3, osc_sample *restrict out4, int n);
+static int block_is_constant(const osc_sample *vec, int n);
+static int allOsc_can_rotate(const osc_allOsc *x, const osc_sample *const *inputs, int n);
+static void allOsc_render_rotating(osc_allOsc *x, const osc_sample *const *inputs, osc_sample *const *outputs, int n);
+static osc_sample wrap_phase(osc_sample phase, osc_sample step);
+#endif
+
+/******************************* [powSine~] *******************************/
+
+// The floating point kernels, see the end of the file for the fixed point ones
+#ifndef OSC_FIXED
+
+void osc_powSine_init(osc_powSine *x, osc_sample sr)
+{
+	// Initialize phase to 0 and sign variable to 1
+	x->phase = 0;
+	x->sign = 1;
+	x->bandlimit = 0;
+
+	// set sampling rate, sampling interval and factor
+	x->sr = sr;
+	x->sifactor = (osc_sample) POWSINE_STEPSIZE / x->sr;
+	x->si = 0;
+}
+
+void osc_powSine_set_param(osc_powSine *x, int param, osc_sample value)
+{
+	switch(param){
+		case OSC_PARAM_SAMPLERATE:
+			x->si *= x->sr / value;
+			x->sr = value;
+			x->sifactor = (osc_sample) POWSINE_STEPSIZE / x->sr;
+			break;
+		case OSC_PARAM_PHASE:
+			x->phase = wrap_phase(value * (osc_sample) POWSINE_STEPSIZE, POWSINE_STEPSIZE);
+			break;
+		case OSC_PARAM_BANDLIMIT:
+			// this runs on the audio thread, so it only checks that osc_tables_init() built the tables
+			x->bandlimit = (value != 0) && powSine_bl_tab;
+			break;
+	}
+}
+
+void osc_powSine_render(osc_powSine *x, const osc_sample *const *inputs, osc_sample *const *outputs, int n)
+{
+	// Copy signal vector pointers
+	const osc_sample *frequency = inputs[0];
+	const osc_sample *phase_mod = inputs[1];
+	const osc_sample *power = inputs[2];
+	osc_sample *out = outputs[0];
+
+	// Dereference components from the state structure
+	osc_sample si_factor = x->sifactor;
+	osc_sample si = x->si;
+	osc_sample phase = x->phase;
+	osc_sample sign = x->sign;
+	// Local variables
+	osc_sample phase_add, phase_double;
+	int phase_trunc, trunc_double;
+	osc_sample phase_wrap, wrap_double;
+	osc_sample step = (osc_sample) POWSINE_STEPSIZE;
+
+	// Render from the band-limited tables instead, if they're switched on
+	if(x->bandlimit) {
+		powSine_render_bandlimited(x, inputs, outputs, n);
+		return;
+	}
+
+	// Perform the DSP loop
+	while(n--){
+		si = *frequency++ * si_factor;
+		// This is kind of copied from [wrap~]'s code
+		phase_add = ((phase / step) + *phase_mod++);
+		phase_trunc = phase_add;
+		if(phase_add > 0) phase_wrap = phase_add - phase_trunc;
+		else phase_wrap = phase_add - (phase_trunc - 1);
+		// [wrap]'s code was up to line above
+		// it's copied once more for wrapping the doubled frequency sent to cos
+		if(phase_wrap > 0.5f) sign = 1;
+		else sign = -1;
+		phase_double = phase_wrap * 2;
+		trunc_double = phase_double;
+		if(phase_double > 0) wrap_double = phase_double - trunc_double;
+		else wrap_double = phase_double - (trunc_double - 1);
+		*out++ = OSC_POW(OSC_FLUSH((OSC_COS(OSC_TWOPI * wrap_double) * -0.5f) + 0.5f), *power++) * sign;
+		phase += si;
+		phase = wrap_phase(phase, step);
+	}
+	// Update the phase and sign variables
+	x->si = si;
+	x->phase = phase;
+	x->sign = sign;
+}
+
+/* The render routine for vectors that don't overlap, picked by osc_type_select().
+   It's split in two passes over chunks of the block: the phase pass carries the
+   phase from each sample to the next, and the waveform pass computes every sample
+   on its own from its phase, so the compiler can run it on vectors. The results
+   are the same as osc_powSine_render()'s, to the bit */
+static void powSine_render_separate(osc_powSine *x, const osc_sample *const *inputs, osc_sample *const *outputs, int n)
+{
+	// Copy signal vector pointers
+	const osc_sample *frequency = inputs[0];
+
+	// Dereference components from the state structure
+	osc_sample si_factor = x->sifactor;
+	osc_sample si = x->si;
+	osc_sample phase = x->phase;
+	osc_sample sign = x->sign;
+	// Local variables
+	osc_sample step = (osc_sample) POWSINE_STEPSIZE;
+	osc_sample phases[OSC_CHUNK]; // passed from the phase pass to the waveform pass
+	int i, chunk, done;
+
+	if(x->bandlimit) {
+		powSine_render_bandlimited(x, inputs, outputs, n);
+		return;
+	}
+
+	for(done = 0; done < n; done += chunk){
+		chunk = n - done < OSC_CHUNK ? n - done : OSC_CHUNK;
+		// The phase pass
+		for(i = 0; i < chunk; i++){
+			phases[i] = phase / step;
+			si = frequency[done + i] * si_factor;
+			phase += si;
+			phase = wrap_phase(phase, step);
+		}
+		sign = powSine_waveform(phases, inputs[1] + done, inputs[2] + done, outputs[0] + done, chunk);
+	}
+	// Update the phase and sign variables
+	x->si = si;
+	x->phase = phase;
+	x->sign = sign;
+}
+
+/* The waveform pass of powSine_render_separate(), returning the last sample's
+   sign. The vectors are restrict-qualified parameters, as that's where compilers
+   take restrict into account, and the wrapping is done without branches */
+static osc_sample powSine_waveform(const osc_sample *restrict phases, const osc_sample *restrict phase_mod,
+	const osc_sample *restrict power, osc_sample *restrict out, int n)
+{
+	osc_sample phase_add, phase_double;
+	int phase_trunc, trunc_double;
+	osc_sample phase_wrap;
+	osc_sample doubled[OSC_CHUNK], signs[OSC_CHUNK];
+	int i;
+
+	for(i = 0; i < n; i++){
+		phase_add = phases[i] + phase_mod[i];
+		phase_trunc = phase_add;
+		phase_wrap = phase_add - (phase_add > 0 ? phase_trunc : phase_trunc - 1);
+		signs[i] = phase_wrap > 0.5f ? 1 : -1;
+		phase_double = phase_wrap * 2;
+		trunc_double = phase_double;
+		doubled[i] = phase_double - (phase_double > 0 ? trunc_double : trunc_double - 1);
+	}
+	// cos() and pow() take a sample at a time, unless the math library has vector versions
+	for(i = 0; i < n; i++)
+		out[i] = OSC_POW(OSC_FLUSH((OSC_COS(OSC_TWOPI * doubled[i]) * -0.5f) + 0.5f), power[i]) * signs[i];
+	return signs[n - 1];
+}
+
+// The band-limited render routine, reading from the tables made by make_bl_tabs()
+static void powSine_render_bandlimited(osc_powSine *x, const osc_sample *const *inputs, osc_sample *const *outputs, int n)
+{
+	// Copy signal vector pointers
+	const osc_sample *frequency = inputs[0];
+	const osc_sample *phase_mod = inputs[1];
+	const osc_sample *power = inputs[2];
+	osc_sample *out = outputs[0];
+
+	// Dereference components from the state structure
+	osc_sample si_factor = x->sifactor;
+	osc_sample si = x->si;
+	osc_sample phase = x->phase;
+	// Local variables
+	osc_sample phase_add;
+	int phase_trunc;
+	osc_sample phase_wrap;
+	osc_sample increment; // phase increment in cycles per sample
+	int level, harmonics;
+	osc_sample power_local, bucket_frac;
+	int bucket;
+	osc_sample index_frac;
+	int index;
+	const osc_sample *tab, *next_tab;
+	osc_sample sample, next_sample;
+	osc_sample step = (osc_sample) POWSINE_STEPSIZE;
+	osc_sample max_power = powSine_bl_powers[POWSINE_BL_BUCKETS - 1];
+	int level_size = POWSINE_BL_TABSIZE + 1;
+	int bucket_size = level_size * POWSINE_BL_LEVELS;
+
+	// Perform the DSP loop
+	while(n--){
+		si = *frequency++ * si_factor;
+		// Same wrapping as in osc_powSine_render()
+		phase_add = ((phase / step) + *phase_mod++);
+		phase_trunc = phase_add;
+		if(phase_add > 0) phase_wrap = phase_add - phase_trunc;
+		else phase_wrap = phase_add - (phase_trunc - 1);
+
+		// pick the richest mip level whose highest harmonic stays below Nyquist
+		increment = si / step;
+		if(increment < 0) increment = -increment;
+		level = 0;
+		harmonics = POWSINE_BL_TABSIZE / 4;
+		while(level < POWSINE_BL_LEVELS - 1 && harmonics * increment > 0.5f) {
+			level++;
+			harmonics >>= 1;
+		}
+
+		// find the two exponent buckets the power lies between
+		power_local = *power++;
+		if(power_local <= 0) {
+			bucket = 0;
+			bucket_frac = 0;
+		}
+		else if(power_local >= max_power) {
+			bucket = POWSINE_BL_BUCKETS - 2;
+			bucket_frac = 1;
+		}
+		else {
+			bucket = 0;
+			while(powSine_bl_powers[bucket + 1] <= power_local) bucket++;
+			bucket_frac = (power_local - powSine_bl_powers[bucket]) /
+				(powSine_bl_powers[bucket + 1] - powSine_bl_powers[bucket]);
+		}
+
+		// read both buckets with linear interpolation and crossfade between them
+		index_frac = phase_wrap * POWSINE_BL_TABSIZE;
+		// a NaN or huge phase modulation must not read outside the tables
+		if(!(index_frac >= 0 && index_frac < POWSINE_BL_TABSIZE)) index_frac = 0;
+		index = index_frac;
+		if(index >= POWSINE_BL_TABSIZE) index = POWSINE_BL_TABSIZE - 1;
+		index_frac -= index;
+		tab = powSine_bl_tab + (bucket * bucket_size) + (level * level_size) + index;
+		next_tab = tab + bucket_size;
+		sample = tab[0] + ((tab[1] - tab[0]) * index_frac);
+		next_sample = next_tab[0] + ((next_tab[1] - next_tab[0]) * index_frac);
+		*out++ = sample + ((next_sample - sample) * bucket_frac);
+		phase += si;
+		phase = wrap_phase(phase, step);
+	}
+	// Update the phase variable
+	x->si = si;
+	x->phase = phase;
+}
+
+// In-place radix-2 complex FFT, used to build band-limited tables. The fixed
+// point build has one of its own, see fixed_fft()
+static void osc_fft(double *real, double *imag, int n, int inverse)
+{
+	int i, j, k, bit, len, half;
+	double angle, rot_real, rot_imag, w_real, w_imag;
+	double u_real, u_imag, v_real, v_imag, tmp;
+
+	// bit-reversal permutation
+	for(i = 1, j = 0; i < n; i++){
+		for(bit = n >> 1; j & bit; bit >>= 1) j ^= bit;
+		j ^= bit;
+		if(i < j) {
+			tmp = real[i]; real[i] = real[j]; real[j] = tmp;
+			tmp = imag[i]; imag[i] = imag[j]; imag[j] = tmp;
+		}
+	}
+	// butterflies
+	for(len = 2; len <= n; len <<= 1){
+		half = len >> 1;
+		angle = (inverse ? 8.0 : -8.0) * atan(1.0) / len;
+		rot_real = cos(angle);
+		rot_imag = sin(angle);
+		for(i = 0; i < n; i += len){
+			w_real = 1;
+			w_imag = 0;
+			for(k = 0; k < half; k++){
+				u_real = real[i + k];
+				u_imag = imag[i + k];
+				v_real = (real[i + k + half] * w_real) - (imag[i + k + half] * w_imag);
+				v_imag = (real[i + k + half] * w_imag) + (imag[i + k + half] * w_real);
+				real[i + k] = u_real + v_real;
+				imag[i + k] = u_imag + v_imag;
+				real[i + k + half] = u_real - v_real;
+				imag[i + k + half] = u_imag - v_imag;
+				tmp = (w_real * rot_real) - (w_imag * rot_imag);
+				w_imag = (w_real * rot_imag) + (w_imag * rot_real);
+				w_real = tmp;
+			}
+		}
+	}
+}
+
+static void make_bl_tabs(void)
+{
+	int bucket, level, harmonics, i;
+	int size = POWSINE_BL_TABSIZE;
+	double *spectrum_real, *spectrum_imag, *real, *imag;
+	double twopi = 8.0 * atan(1.0);
+	double phase_wrap, phase_double, sign;
+	osc_sample *tab, *fp;
+	// the exponents are part of the checksum, so changing them rebuilds the cache
+	uint64_t seed = cache_checksum(powSine_bl_powers, sizeof(powSine_bl_powers), 0);
+#ifdef OSC_CACHE
+	const osc_sample *mapped;
+	char path[1024];
+	int cached;
+#endif
+
+	// first check if another [powSine~] has already built the tables, or failed to
+	if(powSine_bl_tried) return;
+	powSine_bl_tried = 1;
+
+#ifdef OSC_CACHE
+	// or by another Pd, maybe running right now, in which case the pages are shared with it
+	cached = cache_path(path, sizeof(path), "powSine_bl");
+	if(cached && (powSine_bl_tab = cache_map(path, POWSINE_BL_COUNT, seed))) return;
+#endif
+
+	tab = (osc_sample *)malloc(sizeof(osc_sample) * POWSINE_BL_COUNT);
+	spectrum_real = (double *)malloc(sizeof(double) * size * 4);
+	if(!tab || !spectrum_real) {
+		free(tab);
+		free(spectrum_real);
+		return;
+	}
+	spectrum_imag = spectrum_real + size;
+	real = spectrum_imag + size;
+	imag = real + size;
+
+	for(bucket = 0, fp = tab; bucket < POWSINE_BL_BUCKETS; bucket++){
+		// one full cycle, the same way osc_powSine_render() computes it
+		for(i = 0; i < size; i++){
+			phase_wrap = (double) i / size;
+			if(phase_wrap > 0.5) sign = 1;
+			else sign = -1;
+			phase_double = phase_wrap * 2;
+			phase_double -= (int) phase_double;
+			spectrum_real[i] = pow(((cos(twopi * phase_double) * -0.5) + 0.5), powSine_bl_powers[bucket]) * sign;
+			spectrum_imag[i] = 0;
+		}
+		osc_fft(spectrum_real, spectrum_imag, size, 0);
+
+		// each level keeps half the harmonics of the previous one
+		for(level = 0, harmonics = size / 4; level < POWSINE_BL_LEVELS; level++, harmonics >>= 1){
+			for(i = 0; i < size; i++){
+				if(i > harmonics && i < size - harmonics) {
+					real[i] = imag[i] = 0;
+				}
+				else {
+					real[i] = spectrum_real[i];
+					imag[i] = spectrum_imag[i];
+				}
+			}
+			osc_fft(real, imag, size, 1);
+			for(i = 0; i < size; i++, fp++) *fp = real[i] / size;
+			// copy the first element to the last position for interpolation
+			*fp++ = real[0] / size;
+		}
+	}
+
+	free(spectrum_real);
+
+#ifdef OSC_CACHE
+	// leave them for the next Pd, and map them back so this one's pages are shared too
+	if(cached) {
+		cache_write(path, tab, POWSINE_BL_COUNT, seed);
+		if((mapped = cache_map(path, POWSINE_BL_COUNT, seed))) {
+			free(tab);
+			powSine_bl_tab = mapped;
+			return;
+		}
+	}
+#endif
+	powSine_bl_tab = tab;
+}
+#endif
+
+/****************************** Table cache *******************************/
+
+// The tables that take long to build are written to a file in the user's cache
+// directory the first time they're built, and every later load maps that file
+// read-only instead of building them again. The pages of a mapped file are shared
+// by every process mapping it, so many Pd processes on a host hold one copy.
+// Set VARIOUS_OSCILLATORS_CACHE to the directory to keep the files in, or to an
+// empty string to build the tables every time
+
+void osc_tables_init(void)
+{
+	// the rest of the tables are compiled in
+#ifndef OSC_FIXED
+	make_bl_tabs();
+#endif
+}
+
+#ifndef OSC_FIXED
+// 64 bit FNV-1a over whole words, reading the tail a byte at a time
+static uint64_t cache_checksum(const void *data, size_t bytes, uint64_t seed)
+{
+	const unsigned char *p = (const unsigned char *) data;
+	uint64_t hash = seed ^ 0xcbf29ce484222325ull, word;
+	size_t i;
+
+	for(i = 0; i + sizeof(word) <= bytes; i += sizeof(word)) {
+		memcpy(&word, p + i, sizeof(word));
+		hash = (hash ^ word) * 0x100000001b3ull;
+	}
+	for(; i < bytes; i++) hash = (hash ^ p[i]) * 0x100000001b3ull;
+	return hash;
+}
+#endif
+
+#ifdef OSC_CACHE
+// Fills in the path of a cache file, creating its directory if needed, returns 0
+// if there's nowhere to keep it. Single and double precision builds get separate files
+static int cache_path(char *path, int size, const char *name)
+{
+	const char *dir = getenv("VARIOUS_OSCILLATORS_CACHE");
+	const char *home;
+	char own[1024];
+	int len;
+
+	if(dir) {
+		if(!*dir) return 0;
+	}
+	else if((home = getenv("XDG_CACHE_HOME")) && *home) {
+		snprintf(own, sizeof(own), "%s/various_oscillators", home);
+		dir = own;
+	}
+	else if((home = getenv("HOME")) && *home) {
+		// ~/.cache itself may not exist yet
+		snprintf(own, sizeof(own), "%s/.cache", home);
+		mkdir(own, 0755);
+		snprintf(own, sizeof(own), "%s/.cache/various_oscillators", home);
+		dir = own;
+	}
+	else return 0;
+	if(mkdir(dir, 0755) && errno != EEXIST) return 0;
+
+	len = snprintf(path, size, "%s/%s-%d.tab", dir, name, OSC_FLOATSIZE);
+	return len > 0 && len < size;
+}
+
+// Maps a cache file read-only, returns its tables or 0 if it's missing or bad
+static const osc_sample *cache_map(const char *path, uint32_t count, uint64_t seed)
+{
+	size_t bytes = sizeof(osc_cache_header) + sizeof(osc_sample) * count;
+	const osc_cache_header *header;
+	struct stat st;
+	void *map;
+	int fd;
+
+	if((fd = open(path, O_RDONLY)) < 0) return 0;
+	if(fstat(fd, &st) || (size_t) st.st_size != bytes) {
+		close(fd);
+		return 0;
+	}
+	map = mmap(0, bytes, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if(map == MAP_FAILED) return 0;
+
+	header = (const osc_cache_header *) map;
+	if(header->magic != OSC_CACHE_MAGIC || header->version != OSC_CACHE_VERSION ||
+		header->samplesize != sizeof(osc_sample) || header->count != count ||
+		header->checksum != cache_checksum(header + 1, sizeof(osc_sample) * count, seed)) {
+		munmap(map, bytes);
+		return 0;
+	}
+	return (const osc_sample *) (header + 1);
+}
+
+// write() may write less than it's asked to
+static int cache_write_all(int fd, const void *data, size_t bytes)
+{
+	const char *p = (const char *) data;
+	ssize_t written;
+
+	while(bytes) {
+		if((written = write(fd, p, bytes)) <= 0) return 0;
+		p += written;
+		bytes -= written;
+	}
+	return 1;
+}
+
+// Writes a cache file. It's written under a temporary name and renamed over the
+// old one, so a Pd starting meanwhile sees either the old file or the whole new
+// one, and a Pd that has the old one mapped keeps reading it undisturbed
+static void cache_write(const char *path, const osc_sample *tab, uint32_t count, uint64_t seed)
+{
+	osc_cache_header header;
+	char tmp[1100];
+	int fd, ok;
+
+	memset(&header, 0, sizeof(header));
+	header.magic = OSC_CACHE_MAGIC;
+	header.version = OSC_CACHE_VERSION;
+	header.samplesize = sizeof(osc_sample);
+	header.count = count;
+	header.checksum = cache_checksum(tab, sizeof(osc_sample) * count, seed);
+
+	snprintf(tmp, sizeof(tmp), "%s.%ld", path, (long) getpid());
+	if((fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0) return;
+	ok = cache_write_all(fd, &header, sizeof(header)) &&
+		cache_write_all(fd, tab, sizeof(osc_sample) * count);
+	if(close(fd)) ok = 0;
+	if(!ok || rename(tmp, path)) unlink(tmp);
+}
+#endif
+
+/******************************* [randOsc~] *******************************/
+
+#ifndef OSC_FIXED
+
+void osc_randOsc_init(osc_randOsc *x, osc_sample sr)
+{
+	// seed every instance differently, like [noise~] does
+	static int init = 307;
+
+	// Initialize phase and random samples to 0
+	x->phase = 0;
+	x->random_sample = 0;
+	x->old_random_sample = 0;
+	x->randval = (init *= 1319);
+
+	// set sampling rate, sampling interval and factor
+	x->sr = sr;
+	x->sifactor = (osc_sample) RANDOSC_STEPSIZE / x->sr;
+	x->si = 0;
+}
+
+void osc_randOsc_set_param(osc_randOsc *x, int param, osc_sample value)
+{
+	switch(param){
+		case OSC_PARAM_SAMPLERATE:
+			x->si *= x->sr / value;
+			x->sr = value;
+			x->sifactor = (osc_sample) RANDOSC_STEPSIZE / x->sr;
+			break;
+		case OSC_PARAM_PHASE:
+			x->phase = wrap_phase(value * (osc_sample) RANDOSC_STEPSIZE, RANDOSC_STEPSIZE);
+			break;
+		case OSC_PARAM_SEED:
+			x->randval = (int) value;
+			break;
+	}
+}
+
+void osc_randOsc_render(osc_randOsc *x, const osc_sample *const *inputs, osc_sample *const *outputs, int n)
+{
+	// Copy signal vector pointers
+	const osc_sample *frequency = inputs[0];
+	const osc_sample *xfade = inputs[1];
+	const osc_sample *power = inputs[2];
+	osc_sample *out = outputs[0];
+
+	// Dereference components from the state structure
+	osc_sample si_factor = x->sifactor;
+	osc_sample si = x->si;
+	osc_sample phase = x->phase;
+	osc_sample random_sample = x->random_sample;
+	osc_sample old_random_sample = x->old_random_sample;
+	int randval = x->randval;
+	// Local variables
+	osc_sample step = (osc_sample) RANDOSC_STEPSIZE;
+	osc_sample xfade_local, invert_xfade;
+	osc_sample cos_phase, tri_phase;
+	osc_sample cos_tri_add;
+	osc_sample noise;
+	// Variables for scale and offset
+	osc_sample scale, offset;
+	osc_sample random_bipolar, old_random_bipolar;
+	osc_sample abs_random_bipolar, abs_old_random_bipolar;
+	osc_sample max_sample, max_absolute_sample;
+	osc_sample sample_diff;
+
+	// Perform the DSP loop
+	while(n--){
+		// Create a random sample at each loop iteration (copied from [noise~]'s code
+		noise = ((osc_sample)((randval & 0x7fffffff) - 0x40000000)) *
+			(osc_sample)(1.0 / 0x40000000);
+		randval = randval * 435898247 + 382842987;
+		noise = noise * 0.5f + 0.5f;
+		// Set xfade vector to a local variable
+		xfade_local = *xfade++;
+		invert_xfade = 1 - xfade_local;
+		// Set scale and offset values according to random samples
+		sample_diff = random_sample - old_random_sample;
+		if(sample_diff < 0) {
+			scale = sample_diff * -1;
+		}
+		else {
+			scale = sample_diff;
+		}
+		random_bipolar = (random_sample * 2) - 1;
+		old_random_bipolar = (old_random_sample * 2) - 1;
+		// Get absolute values of bipolar random values
+		if(random_bipolar < 0) {
+			abs_random_bipolar = random_bipolar * -1;
+		}
+		else {
+			abs_random_bipolar = random_bipolar;
+		}
+		if(old_random_bipolar < 0) {
+			abs_old_random_bipolar = old_random_bipolar * -1;
+		}
+		else {
+			abs_old_random_bipolar = old_random_bipolar;
+		}
+		// Get maximum absolute sample
+		if(abs_random_bipolar > abs_old_random_bipolar) {
+			max_absolute_sample = abs_random_bipolar;
+		}
+		else {
+			max_absolute_sample = abs_old_random_bipolar;
+		}
+		offset = max_absolute_sample - scale;
+		// Get maximum sample
+		if(random_bipolar > old_random_bipolar) {
+			max_sample = random_bipolar;
+		}
+		else {
+			max_sample = old_random_bipolar;
+		}
+		if(max_sample > scale) {
+			offset *= 1;
+		}
+		else {
+			offset *= -1;
+		}
+		// Phase increment
+		si = *frequency++ * si_factor;
+		// Cosine and triangle values
+		if(random_sample > old_random_sample) {
+			cos_phase = ((phase / step) * 0.5f) + 0.5f;
+			tri_phase = phase / step;
+		}
+		else {
+			cos_phase = (phase / step) * 0.5f;
+			tri_phase = ((phase / step) * -1) + 1;
+		}
+		cos_tri_add = (((OSC_COS(OSC_TWOPI * cos_phase) * 0.5f) + 0.5f) * invert_xfade) + (tri_phase * xfade_local);
+		*out++ = (((OSC_POW(OSC_FLUSH(cos_tri_add), *power++) * 2) - 1) * scale) + offset;
+		phase += si;
+		// a new random target at the end of each cycle
+		if(phase > step) {
+			phase -= step;
+			old_random_sample = random_sample;
+			random_sample = noise;
+			// more than one cycle in a sample, the skipped ones all got the same noise sample
+			if(phase > step) old_random_sample = noise;
+		}
+		phase = wrap_phase(phase, step);
+	}
+
+	// Update the phase, random samples and generator
+	x->si = si;
+	x->phase = phase;
+	x->random_sample = random_sample;
+	x->old_random_sample = old_random_sample;
+	x->randval = randval;
+}
+
+// The render routine for vectors that don't overlap, in passes like powSine_render_separate()
+static void randOsc_render_separate(osc_randOsc *x, const osc_sample *const *inputs, osc_sample *const *outputs, int n)
+{
+	// Copy signal vector pointers
+	const osc_sample *frequency = inputs[0];
+
+	// Dereference components from the state structure
+	osc_sample si_factor = x->sifactor;
+	osc_sample si = x->si;
+	osc_sample phase = x->phase;
+	osc_sample random_sample = x->random_sample;
+	osc_sample old_random_sample = x->old_random_sample;
+	int randval = x->randval;
+	// Local variables
+	osc_sample step = (osc_sample) RANDOSC_STEPSIZE;
+	osc_sample noise;
+	// passed from the phase pass to the waveform pass
+	osc_sample phases[OSC_CHUNK], randoms[OSC_CHUNK], old_randoms[OSC_CHUNK];
+	int i, chunk, done;
+
+	for(done = 0; done < n; done += chunk){
+		chunk = n - done < OSC_CHUNK ? n - done : OSC_CHUNK;
+		// The phase pass, the random values change where the phase wraps
+		for(i = 0; i < chunk; i++){
+			noise = ((osc_sample)((randval & 0x7fffffff) - 0x40000000)) *
+				(osc_sample)(1.0 / 0x40000000);
+			randval = randval * 435898247 + 382842987;
+			noise = noise * 0.5f + 0.5f;
+			phases[i] = phase / step;
+			randoms[i] = random_sample;
+			old_randoms[i] = old_random_sample;
+			si = frequency[done + i] * si_factor;
+			phase += si;
+			if(phase > step) {
+				phase -= step;
+				old_random_sample = random_sample;
+				random_sample = noise;
+				if(phase > step) old_random_sample = noise;
+			}
+			phase = wrap_phase(phase, step);
+		}
+		randOsc_waveform(phases, randoms, old_randoms, inputs[1] + done, inputs[2] + done, outputs[0] + done, chunk);
+	}
+
+	// Update the phase, random samples and generator
+	x->si = si;
+	x->phase = phase;
+	x->random_sample = random_sample;
+	x->old_random_sample = old_random_sample;
+	x->randval = randval;
+}
+
+// The waveform pass of randOsc_render_separate(), see powSine_waveform()
+static void randOsc_waveform(const osc_sample *restrict phases, const osc_sample *restrict randoms,
+	const osc_sample *restrict old_randoms, const osc_sample *restrict xfade, const osc_sample *restrict power,
+	osc_sample *restrict out, int n)
+{
+	osc_sample xfade_local;
+	// Variables for scale and offset
+	osc_sample scale, offset;
+	osc_sample random_bipolar, old_random_bipolar;
+	osc_sample abs_random_bipolar, abs_old_random_bipolar;
+	osc_sample max_sample, max_absolute_sample;
+	osc_sample sample_diff;
+	int rising;
+	osc_sample cos_phases[OSC_CHUNK], tri_phases[OSC_CHUNK], scales[OSC_CHUNK], offsets[OSC_CHUNK];
+	int i;
+
+	for(i = 0; i < n; i++){
+		sample_diff = randoms[i] - old_randoms[i];
+		scale = sample_diff < 0 ? sample_diff * -1 : sample_diff;
+		random_bipolar = (randoms[i] * 2) - 1;
+		old_random_bipolar = (old_randoms[i] * 2) - 1;
+		abs_random_bipolar = random_bipolar < 0 ? random_bipolar * -1 : random_bipolar;
+		abs_old_random_bipolar = old_random_bipolar < 0 ? old_random_bipolar * -1 : old_random_bipolar;
+		max_absolute_sample = abs_random_bipolar > abs_old_random_bipolar ? abs_random_bipolar : abs_old_random_bipolar;
+		max_sample = random_bipolar > old_random_bipolar ? random_bipolar : old_random_bipolar;
+		offset = max_absolute_sample - scale;
+		offsets[i] = max_sample > scale ? offset : offset * -1;
+		scales[i] = scale;
+		// cosine and triangle phases
+		rising = randoms[i] > old_randoms[i];
+		cos_phases[i] = rising ? (phases[i] * 0.5f) + 0.5f : phases[i] * 0.5f;
+		tri_phases[i] = rising ? phases[i] : (phases[i] * -1) + 1;
+	}
+	// cos() and pow() take a sample at a time, unless the math library has vector versions
+	for(i = 0; i < n; i++){
+		xfade_local = xfade[i];
+		out[i] = OSC_POW(OSC_FLUSH((((OSC_COS(OSC_TWOPI * cos_phases[i]) * 0.5f) + 0.5f) * (1 - xfade_local)) +
+			(tri_phases[i] * xfade_local)), power[i]);
+	}
+	for(i = 0; i < n; i++) out[i] = (((out[i] * 2) - 1) * scales[i]) + offsets[i];
+}
+#endif
+
+/***************************** [varShapesOsc~] *****************************/
+
+#ifndef OSC_FIXED
+
+void osc_varShapesOsc_init(osc_varShapesOsc *x, osc_sample sr)
+{
+	// Initialize phase to 0
+	x->phase = 0;
+
+	// set sampling rate, sampling interval and factor
+	x->sr = sr;
+	x->sifactor = (osc_sample) VARSHAPES_STEPSIZE / x->sr;
+	x->si = 0;
+}
+
+void osc_varShapesOsc_set_param(osc_varShapesOsc *x, int param, osc_sample value)
+{
+	switch(param){
+		case OSC_PARAM_SAMPLERATE:
+			x->si *= x->sr / value;
+			x->sr = value;
+			x->sifactor = (osc_sample) VARSHAPES_STEPSIZE / x->sr;
+			break;
+		case OSC_PARAM_PHASE:
+			x->phase = wrap_phase(value * (osc_sample) VARSHAPES_STEPSIZE, VARSHAPES_STEPSIZE);
+			break;
+	}
+}
+
+void osc_varShapesOsc_render(osc_varShapesOsc *x, const osc_sample *const *inputs, osc_sample *const *outputs, int n)
+{
+	// Copy signal vector pointers
+	const osc_sample *frequency = inputs[0];
+	const osc_sample *phase_mod = inputs[1];
+	const osc_sample *xfade = inputs[2];
+	const osc_sample *breakpoint = inputs[3];
+	const osc_sample *rise_power = inputs[4];
+	const osc_sample *fall_power = inputs[5];
+	osc_sample *out = outputs[0];
+
+	// Dereference components from the state structure
+	osc_sample si_factor = x->sifactor;
+	osc_sample si = x->si;
+	osc_sample phase = x->phase;
+	// Local variables
+	osc_sample step = (osc_sample) VARSHAPES_STEPSIZE;
+	osc_sample breakpoint_local, invert_brk;
+	osc_sample xfade_local, invert_xfade;
+	osc_sample cos_phase, tri_phase;
+	osc_sample rise_power_local, fall_power_local;
+	osc_sample cos_tri_add, power_add;
+	osc_sample phase_add;
+	int phase_trunc;
+	osc_sample phase_wrap;
+
+	// Perform the DSP loop
+	while(n--){
+		breakpoint_local = *breakpoint++;
+		invert_brk = 1 - breakpoint_local;
+		xfade_local = *xfade++;
+		invert_xfade = 1 - xfade_local;
+		rise_power_local = *rise_power++;
+		fall_power_local = *fall_power++;
+		si = *frequency++ * si_factor;
+		// This is kind of copied from [wrap~]'s code
+		phase_add = ((phase / step) + *phase_mod++);
+		phase_trunc = phase_add;
+		if(phase_add > 0) phase_wrap = phase_add - phase_trunc;
+		else phase_wrap = phase_add - (phase_trunc - 1);
+		// [wrap]'s code was up to line above
+		if(phase_wrap < breakpoint_local) {
+			cos_phase = ((phase_wrap / breakpoint_local) * 0.5f) + 0.5f;
+			tri_phase = phase_wrap / breakpoint_local;
+			fall_power_local = 0;
+		}
+		else if(invert_brk > 0) {
+			cos_phase = ((phase_wrap - breakpoint_local) / invert_brk) * 0.5f;
+			tri_phase = (invert_brk - (phase_wrap - breakpoint_local)) / invert_brk;
+			rise_power_local = 0;
+		}
+		else {
+			// a breakpoint of 1 has no fall, phase_wrap only gets here by rounding
+			cos_phase = 0.5f;
+			tri_phase = 0;
+			rise_power_local = 0;
+		}
+		cos_tri_add = (((OSC_COS(OSC_TWOPI * cos_phase) * 0.5f) + 0.5f) * invert_xfade) + (tri_phase * xfade_local);
+		power_add = rise_power_local + fall_power_local;
+		*out++ = (OSC_POW(OSC_FLUSH(cos_tri_add), power_add) * 2) - 1;
+		phase += si;
+		phase = wrap_phase(phase, step);
+	}
+	// Update the phase variable
+	x->si = si;
+	x->phase = phase;
+}
+
+// The render routine for vectors that don't overlap, in passes like powSine_render_separate()
+static void varShapesOsc_render_separate(osc_varShapesOsc *x, const osc_sample *const *inputs, osc_sample *const *outputs, int n)
+{
+	// Copy signal vector pointers
+	const osc_sample *frequency = inputs[0];
+
+	// Dereference components from the state structure
+	osc_sample si_factor = x->sifactor;
+	osc_sample si = x->si;
+	osc_sample phase = x->phase;
+	// Local variables
+	osc_sample step = (osc_sample) VARSHAPES_STEPSIZE;
+	osc_sample phases[OSC_CHUNK]; // passed from the phase pass to the waveform pass
+	int i, chunk, done;
+
+	for(done = 0; done < n; done += chunk){
+		chunk = n - done < OSC_CHUNK ? n - done : OSC_CHUNK;
+		// The phase pass
+		for(i = 0; i < chunk; i++){
+			phases[i] = phase / step;
+			si = frequency[done + i] * si_factor;
+			phase += si;
+			phase = wrap_phase(phase, step);
+		}
+		varShapesOsc_waveform(phases, inputs[1] + done, inputs[2] + done, inputs[3] + done, inputs[4] + done,
+			inputs[5] + done, outputs[0] + done, chunk);
+	}
+	// Update the phase variable
+	x->si = si;
+	x->phase = phase;
+}
+
+/* The waveform pass of varShapesOsc_render_separate(), see powSine_waveform().
+   Both sides of the breakpoint are computed and one of them is picked. Which
+   power is used is picked in the scalar loop, compilers don't vectorize picking
+   between two vectors' samples */
+static void varShapesOsc_waveform(const osc_sample *restrict phases, const osc_sample *restrict phase_mod,
+	const osc_sample *restrict xfade, const osc_sample *restrict breakpoint, const osc_sample *restrict rise_power,
+	const osc_sample *restrict fall_power, osc_sample *restrict out, int n)
+{
+	osc_sample breakpoint_local, invert_brk;
+	osc_sample xfade_local;
+	osc_sample phase_add;
+	int phase_trunc;
+	osc_sample phase_wrap;
+	osc_sample rise, fall, fall_tri;
+	int rising;
+	osc_sample cos_phases[OSC_CHUNK], tri_phases[OSC_CHUNK], risings[OSC_CHUNK];
+	int i;
+
+	for(i = 0; i < n; i++){
+		breakpoint_local = breakpoint[i];
+		invert_brk = 1 - breakpoint_local;
+		phase_add = phases[i] + phase_mod[i];
+		phase_trunc = phase_add;
+		phase_wrap = phase_add - (phase_add > 0 ? phase_trunc : phase_trunc - 1);
+		rise = phase_wrap / breakpoint_local;
+		fall = (phase_wrap - breakpoint_local) / invert_brk;
+		fall_tri = (invert_brk - (phase_wrap - breakpoint_local)) / invert_brk;
+		// a breakpoint of 1 has no fall, phase_wrap only gets past it by rounding
+		fall = invert_brk > 0 ? fall * 0.5f : 0.5f;
+		fall_tri = invert_brk > 0 ? fall_tri : 0;
+		rising = phase_wrap < breakpoint_local;
+		cos_phases[i] = rising ? (rise * 0.5f) + 0.5f : fall;
+		tri_phases[i] = rising ? rise : fall_tri;
+		risings[i] = rising ? 1 : 0;
+	}
+	// cos() and pow() take a sample at a time, unless the math library has vector versions
+	for(i = 0; i < n; i++){
+		xfade_local = xfade[i];
+		out[i] = OSC_POW(OSC_FLUSH((((OSC_COS(OSC_TWOPI * cos_phases[i]) * 0.5f) + 0.5f) * (1 - xfade_local)) +
+			(tri_phases[i] * xfade_local)), risings[i] ? rise_power[i] : fall_power[i]);
+	}
+	for(i = 0; i < n; i++) out[i] = (out[i] * 2) - 1;
+}
+
+#endif
+
+/******************************** [allOsc~] ********************************/
+
+#ifndef OSC_FIXED
+
+void osc_allOsc_init(osc_allOsc *x, osc_sample sr)
+{
+	// Initialize phase to 0
+	x->phase = 0;
+
+	// set sampling rate, sampling interval and factor
+	x->sr = sr;
+	x->sifactor = (osc_sample) ALLOSC_STEPSIZE / x->sr;
+	x->si = 0;
+}
+
+void osc_allOsc_set_param(osc_allOsc *x, int param, osc_sample value)
+{
+	switch(param){
+		case OSC_PARAM_SAMPLERATE:
+			x->si *= x->sr / value;
+			x->sr = value;
+			x->sifactor = (osc_sample) ALLOSC_STEPSIZE / x->sr;
+			break;
+		case OSC_PARAM_PHASE:
+			x->phase = wrap_phase(value * (osc_sample) ALLOSC_STEPSIZE, ALLOSC_STEPSIZE);
+			break;
+	}
+}
+
+void osc_allOsc_render(osc_allOsc *x, const osc_sample *const *inputs, osc_sample *const *outputs, int n)
+{
+	// Copy signal vector pointers
+	const osc_sample *frequency = inputs[0];
+	const osc_sample *phase_mod = inputs[1];
+	const osc_sample *duty_cycle = inputs[2];
+	osc_sample *out1 = outputs[0];
+	osc_sample *out2 = outputs[1];
+	osc_sample *out3 = outputs[2];
+	osc_sample *out4 = outputs[3];
+
+	// Dereference components from the state structure
+	osc_sample si_factor = x->sifactor;
+	osc_sample si = x->si;
+	osc_sample phase = x->phase;
+	// Local variables
+	osc_sample duty_cycle_local;
+	osc_sample phase_add;
+	int phase_trunc;
+	osc_sample phase_wrap;
+	osc_sample invert_phase; // used for the triangle
+	osc_sample cos_phase, tri_phase, saw_phase, square_phase;
+	osc_sample step = (osc_sample) ALLOSC_STEPSIZE;
+
+	// A fixed pitch without phase modulation gets its cosine from a rotating phasor,
+	// unless the block is too short to make up for starting the phasor
+	if(allOsc_can_rotate(x, inputs, n)) {
+		allOsc_render_rotating(x, inputs, outputs, n);
+		return;
+	}
+
+	// Perform the DSP loop
+	while(n--){
+		si = *frequency++ * si_factor;
+		duty_cycle_local = *duty_cycle++;
+		// This is kind of copied from [wrap~]'s code
+		phase_add = ((phase / step) + *phase_mod++);
+		phase_trunc = phase_add;
+		if(phase_add > 0) phase_wrap = phase_add - phase_trunc;
+		else phase_wrap = phase_add - (phase_trunc - 1);
+
+		// cosine values (starting from -1 to be in phase with the triangle)
+		cos_phase = OSC_COS(OSC_TWOPI * phase_wrap) * -1;
+
+		// triangle values
+		invert_phase = (phase_wrap * -1) + 1;
+		if(phase_wrap < invert_phase) tri_phase = phase_wrap;
+		else tri_phase = invert_phase;
+		tri_phase = (tri_phase * 4) - 1;
+
+		// sawtooth values
+		saw_phase = (phase_wrap * 2) - 1;
+
+		// square wave values
+		if(phase_wrap < duty_cycle_local) square_phase = -1;
+		else square_phase = 1;
+
+		// Set values to respective outlets
+		*out1++ = cos_phase;
+		*out2++ = tri_phase;
+		*out3++ = saw_phase;
+		*out4++ = square_phase;
+		phase += si;
+		phase = wrap_phase(phase, step);
+	}
+	// Update the phase variable
+	x->si = si;
+	x->phase = phase;
+}
+
+// The render routine for vectors that don't overlap, in passes like powSine_render_separate()
+static void allOsc_render_separate(osc_allOsc *x, const osc_sample *const *inputs, osc_sample *const *outputs, int n)
+{
+	// Copy signal vector pointers
+	const osc_sample *frequency = inputs[0];
+
+	// Dereference components from the state structure
+	osc_sample si_factor = x->sifactor;
+	osc_sample si = x->si;
+	osc_sample phase = x->phase;
+	// Local variables
+	osc_sample step = (osc_sample) ALLOSC_STEPSIZE;
+	osc_sample phases[OSC_CHUNK]; // passed from the phase pass to the waveform pass
+	int i, chunk, done;
+
+	// The same rotating phasor as osc_allOsc_render() for a fixed pitch
+	if(allOsc_can_rotate(x, inputs, n)) {
+		allOsc_render_rotating(x, inputs, outputs, n);
+		return;
+	}
+
+	for(done = 0; done < n; done += chunk){
+		chunk = n - done < OSC_CHUNK ? n - done : OSC_CHUNK;
+		// The phase pass
+		for(i = 0; i < chunk; i++){
+			phases[i] = phase / step;
+			si = frequency[done + i] * si_factor;
+			phase += si;
+			phase = wrap_phase(phase, step);
+		}
+		allOsc_waveform(phases, inputs[1] + done, inputs[2] + done, outputs[0] + done, outputs[1] + done,
+			outputs[2] + done, outputs[3] + done, chunk);
+	}
+	// Update the phase variable
+	x->si = si;
+	x->phase = phase;
+}
+
+/* The waveform pass of allOsc_render_separate(), see powSine_waveform(). The
+   cosine's outlet holds the wrapped phase until cos() is taken */
+static void allOsc_waveform(const osc_sample *restrict phases, const osc_sample *restrict phase_mod,
+	const osc_sample *restrict duty_cycle, osc_sample *restrict out1, osc_sample *restrict out2,
+	osc_sample *restrict out3, osc_sample *restrict out4, int n)
+{
+	osc_sample phase_add;
+	int phase_trunc;
+	osc_sample phase_wrap;
+	osc_sample invert_phase; // used for the triangle
+	int i;
+
+	for(i = 0; i < n; i++){
+		phase_add = phases[i] + phase_mod[i];
+		phase_trunc = phase_add;
+		phase_wrap = phase_add - (phase_add > 0 ? phase_trunc : phase_trunc - 1);
+		invert_phase = (phase_wrap * -1) + 1;
+		out1[i] = phase_wrap;
+		out2[i] = ((phase_wrap < invert_phase ? phase_wrap : invert_phase) * 4) - 1;
+		out3[i] = (phase_wrap * 2) - 1;
+		out4[i] = phase_wrap < duty_cycle[i] ? -1 : 1;
+	}
+	// cos() takes a sample at a time, unless the math library has a vector version
+	for(i = 0; i < n; i++) out1[i] = OSC_COS(OSC_TWOPI * out1[i]) * -1;
+}
+
+/* Wrap a phase into 0 - step in constant time, however large the increment that
+   got it out of there. The usual case, less than a cycle per sample, takes the
+   same single subtraction the old while loops took, and those never ended for
+   an infinite frequency. A phase that isn't finite anymore restarts from 0
+   instead of silencing the oscillator for good, and so does one so close to 0
+   it would keep the arithmetic on denormals */
+static osc_sample wrap_phase(osc_sample phase, osc_sample step)
+{
+	if(phase > step) {
+		phase -= step;
+		if(phase > step) phase -= OSC_FLOOR(phase / step) * step;
+	}
+	else if(phase < 0) {
+		phase += step;
+		if(phase < 0) phase -= OSC_FLOOR(phase / step) * step;
+	}
+	if(!(phase >= OSC_TINY && phase <= step)) phase = 0;
+	return phase;
+}
+
+// Check whether a signal vector holds the same value throughout the block
+static int block_is_constant(const osc_sample *vec, int n)
+{
+	osc_sample first = vec[0];
+	int i;
+
+	for(i = 1; i < n; i++)
+		if(vec[i] != first) return 0;
+	return 1;
+}
+
+/* Whether a block can be rendered from a rotating phasor: 8 samples or more,
+   with a constant frequency and phase modulation, and a finite start and
+   rotation. A phase or frequency that isn't finite would make the phasor NaN
+   for the whole block, where the sample by sample kernels start over from the
+   next sample, and an increment of more than a cycle per sample aliases
+   anyway, so both are left to those */
+static int allOsc_can_rotate(const osc_allOsc *x, const osc_sample *const *inputs, int n)
+{
+	double start, cycles;
+
+	if(n < 8 || !block_is_constant(inputs[0], n) || !block_is_constant(inputs[1], n)) return 0;
+	start = (double) x->phase / ALLOSC_STEPSIZE + inputs[1][0];
+	cycles = (double) inputs[0][0] * x->sifactor / ALLOSC_STEPSIZE;
+	return isfinite(start) && isfinite(cycles) && fabs(cycles) <= 1;
+}
+
+/* The render routine for blocks with constant frequency and phase modulation.
+   Instead of a cos() per sample, the cosine is the real part of a complex phasor
+   that's rotated by the phase increment, one complex multiply per sample. The
+   phasor is started from the exact phase at every block, so it never drifts from
+   the phase the other waveforms are computed from, and it's kept in double
+   precision so it doesn't lose its length within a block */
+static void allOsc_render_rotating(osc_allOsc *x, const osc_sample *const *inputs, osc_sample *const *outputs, int n)
+{
+	// Copy signal vector pointers, frequency and phase modulation are read once
+	// before anything is written, as the outputs may share their vectors
+	const osc_sample *duty_cycle = inputs[2];
+	osc_sample *out1 = outputs[0];
+	osc_sample *out2 = outputs[1];
+	osc_sample *out3 = outputs[2];
+	osc_sample *out4 = outputs[3];
+	osc_sample phase_mod = inputs[1][0];
+
+	// Dereference components from the state structure
+	osc_sample si = inputs[0][0] * x->sifactor;
+	osc_sample phase = x->phase;
+	// Local variables
+	osc_sample duty_cycle_local;
+	osc_sample phase_add;
+	int phase_trunc;
+	osc_sample phase_wrap;
+	osc_sample invert_phase; // used for the triangle
+	osc_sample tri_phase, saw_phase, square_phase;
+	osc_sample step = (osc_sample) ALLOSC_STEPSIZE;
+	// the phasor and its rotation per sample
+	double re, im, rot_re, rot_im, tmp;
+
+	phase_add = ((phase / step) + phase_mod);
+	re = cos(6.283185307179586 * phase_add);
+	im = sin(6.283185307179586 * phase_add);
+	rot_re = cos(6.283185307179586 * (si / step));
+	rot_im = sin(6.283185307179586 * (si / step));
+
+	// Perform the DSP loop
+	while(n--){
+		duty_cycle_local = *duty_cycle++;
+		// This is kind of copied from [wrap~]'s code
+		phase_add = ((phase / step) + phase_mod);
+		phase_trunc = phase_add;
+		if(phase_add > 0) phase_wrap = phase_add - phase_trunc;
+		else phase_wrap = phase_add - (phase_trunc - 1);
+
+		// triangle values
+		invert_phase = (phase_wrap * -1) + 1;
+		if(phase_wrap < invert_phase) tri_phase = phase_wrap;
+		else tri_phase = invert_phase;
+		tri_phase = (tri_phase * 4) - 1;
+
+		// sawtooth values
+		saw_phase = (phase_wrap * 2) - 1;
+
+		// square wave values
+		if(phase_wrap < duty_cycle_local) square_phase = -1;
+		else square_phase = 1;
+
+		// Set values to respective outlets
+		// cosine values (starting from -1 to be in phase with the triangle)
+		*out1++ = (osc_sample) -re;
+		*out2++ = tri_phase;
+		*out3++ = saw_phase;
+		*out4++ = square_phase;
+		// rotate the phasor
+		tmp = re * rot_re - im * rot_im;
+		im = re * rot_im + im * rot_re;
+		re = tmp;
+		phase += si;
+		phase = wrap_phase(phase, step);
+	}
+	// Update the phase variable
+	x->si = si;
+	x->phase = phase;
+}
+
+#endif
+
+/******************************* [sineLoop~] *******************************/
+
+#ifndef OSC_FIXED
+
+void osc_sineLoop_init(osc_sineLoop *x, osc_sample sr)
+{
+	// Initialize phase and last sample to 0
+	x->phase = 0;
+	x->last_sample = 0;
+
+	// set sampling rate, sampling interval and factor
+	x->sr = sr;
+	x->sifactor = (osc_sample) SINELOOP_STEP / x->sr;
+	x->si = 0;
+}
+
+void osc_sineLoop_set_param(osc_sineLoop *x, int param, osc_sample value)
+{
+	switch(param){
+		case OSC_PARAM_SAMPLERATE:
+			x->si *= x->sr / value;
+			x->sr = value;
+			x->sifactor = (osc_sample) SINELOOP_STEP / x->sr;
+			break;
+		case OSC_PARAM_PHASE:
+			x->phase = wrap_phase(value * (osc_sample) SINELOOP_STEP, SINELOOP_STEP);
+			break;
+	}
+}
+
+void osc_sineLoop_render(osc_sineLoop *x, const osc_sample *const *inputs, osc_sample *const *outputs, int n)
+{
+	// Copy signal vector pointers
+	const osc_sample *frequency = inputs[0];
+	const osc_sample *fb_amount = inputs[1];
+	osc_sample *out = outputs[0];
+
+	// Dereference components from the state structure
+	osc_sample last_sample = x->last_sample;
+	osc_sample si_factor = x->sifactor;
+	osc_sample si = x->si;
+	osc_sample phase = x->phase;
+	const osc_sample *sine_tab = sineLoop_tab;
+	// Local variables
+	osc_sample phase_local;
+	osc_sample feedback;
+	osc_sample frac;
+	int int_part;
+	osc_sample step = (osc_sample) SINELOOP_STEP;
+	osc_sample one_over_step = sineLoop_one_over_step;
+
+	// Perform the DSP loop
+	while(n--){
+		// add it to the frequency
+		si = *frequency++ * si_factor;
+		// take the current out sample for the feedback
+		feedback = *fb_amount++;
+		// clip it (NaN included)
+		if(feedback >= 1.0f) feedback = 1.0f;
+		else if(!(feedback >= 0.0f)) feedback = 0.0f;
+		feedback *= step;
+
+		// wrap phase, with floor() instead of SineLoop's int cast, which overflows
+		// for huge phases and would read far outside the table
+		if(phase < 0 || phase >= step) phase -= OSC_FLOOR(phase * one_over_step) * step;
+		if(!(phase >= OSC_TINY && phase < step)) phase = 0;
+
+		// add the last sample with its index
+		phase_local = phase + last_sample * feedback;
+		// wrap local phase
+		if(phase_local < 0) phase_local += step;
+		else if(phase_local >= step) phase_local -= step;
+		if(!(phase_local >= 0 && phase_local < step)) phase_local = 0;
+
+		int_part = (int)phase_local;
+		frac = phase_local - int_part;
+		*out++ = last_sample = sine_tab[int_part] * (1.0f - frac) + sine_tab[int_part + 1] * frac;
+		phase += si;
+	}
+	// Update the phase and last_sample variables
+	x->si = si;
+	x->phase = phase;
+	x->last_sample = last_sample;
+}
+#endif
+
+/***************************** [sineLoopBank~] *****************************/
+
+#ifndef OSC_FIXED
+
+void osc_sineLoopBank_init(osc_sineLoopBank *x, osc_sample sr, int nvoices)
+{
+	if(nvoices < 1) nvoices = 1;
+	if(nvoices > OSC_SINELOOPBANK_MAXVOICES) nvoices = OSC_SINELOOPBANK_MAXVOICES;
+	x->nvoices = nvoices;
+
+	// all voices, including the ones past nvoices filling up the last lanes, start
+	// silent at the start of their cycle
+	memset(x->frequency, 0, sizeof(x->frequency));
+	memset(x->feedback, 0, sizeof(x->feedback));
+	memset(x->phase, 0, sizeof(x->phase));
+	memset(x->last_sample, 0, sizeof(x->last_sample));
+
+	x->sr = sr;
+	x->sifactor = (osc_sample) SINELOOP_STEP / x->sr;
+}
+
+void osc_sineLoopBank_set_param(osc_sineLoopBank *x, int voice, int param, osc_sample value)
+{
+	int first = voice, last = voice + 1;
+
+	if(param == OSC_PARAM_SAMPLERATE) {
+		x->sr = value;
+		x->sifactor = (osc_sample) SINELOOP_STEP / x->sr;
+		return;
+	}
+	if(voice < 0) {
+		first = 0;
+		last = x->nvoices;
+	}
+	else if(voice >= x->nvoices) return;
+
+	for(voice = first; voice < last; voice++){
+		switch(param){
+			case OSC_PARAM_PHASE:
+				x->phase[voice] = wrap_phase(value * (osc_sample) SINELOOP_STEP, SINELOOP_STEP);
+				break;
+			case OSC_PARAM_FREQUENCY:
+				x->frequency[voice] = value;
+				break;
+			case OSC_PARAM_FEEDBACK:
+				// clipped here, like [sineLoop~] clips its input (NaN included)
+				if(value >= 1.0f) value = 1.0f;
+				else if(!(value >= 0.0f)) value = 0.0f;
+				x->feedback[voice] = value * (osc_sample) SINELOOP_STEP;
+				break;
+		}
+	}
+}
+
+void osc_sineLoopBank_render(osc_sineLoopBank *x, const osc_sample *ratio, osc_sample *const *outputs, osc_sample *mix, int n)
+{
+	const osc_sample *sine_tab = sineLoop_tab;
+	osc_sample si_factor = x->sifactor;
+	osc_sample step = (osc_sample) SINELOOP_STEP;
+	osc_sample one_over_step = sineLoop_one_over_step;
+	osc_sample *phase = x->phase, *last_sample = x->last_sample;
+	const osc_sample *frequency = x->frequency, *feedback = x->feedback;
+	// the voices past the last one, up to a whole number of lanes, are rendered
+	// too and thrown away, so the loops below never need a scalar tail
+	int nvoices = x->nvoices;
+	int nlanes = (nvoices + OSC_SINELOOPBANK_LANES - 1) / OSC_SINELOOPBANK_LANES * OSC_SINELOOPBANK_LANES;
+	osc_sample frac[OSC_SINELOOPBANK_MAXVOICES], left[OSC_SINELOOPBANK_MAXVOICES], right[OSC_SINELOOPBANK_MAXVOICES];
+	int index[OSC_SINELOOPBANK_MAXVOICES];
+	osc_sample cycles, phase_local, ratio_local, sum;
+	int voice, i, whole;
+
+	for(i = 0; i < n; i++){
+		ratio_local = ratio[i];
+		// The same steps as osc_sineLoop_render(), with the same results, split
+		// in three loops over the voices. The first and last have no branches
+		// or calls, so that they run on a vector of voices at a time
+		for(voice = 0; voice < nlanes; voice++){
+			// floor() by truncating and stepping down for negative phases, a
+			// phase too far off (or NaN) for an int is reset by the check below
+			cycles = phase[voice] * one_over_step;
+			cycles = (cycles > -1e9f) & (cycles < 1e9f) ? cycles : 0;
+			whole = (int)cycles;
+			whole -= whole > cycles;
+			phase[voice] -= whole * step;
+			phase[voice] = (phase[voice] >= OSC_TINY) & (phase[voice] < step) ? phase[voice] : 0;
+
+			phase_local = phase[voice] + last_sample[voice] * feedback[voice];
+			phase_local += phase_local < 0 ? step : 0;
+			phase_local -= phase_local >= step ? step : 0;
+			phase_local = (phase_local >= 0) & (phase_local < step) ? phase_local : 0;
+
+			index[voice] = (int)phase_local;
+			frac[voice] = phase_local - index[voice];
+		}
+		// the table look-ups, one voice at a time
+		for(voice = 0; voice < nlanes; voice++){
+			left[voice] = sine_tab[index[voice]];
+			right[voice] = sine_tab[index[voice] + 1];
+		}
+		for(voice = 0; voice < nlanes; voice++){
+			last_sample[voice] = left[voice] * (1.0f - frac[voice]) + right[voice] * frac[voice];
+			phase[voice] += (frequency[voice] * ratio_local) * si_factor;
+		}
+
+		if(outputs) {
+			for(voice = 0; voice < nvoices; voice++) outputs[voice][i] = last_sample[voice];
+		}
+		if(mix) {
+			for(voice = 0, sum = 0; voice < nvoices; voice++) sum += last_sample[voice];
+			mix[i] = sum;
+		}
+	}
+}
+
+#endif
+
+/******************************** [tabOsc~] ********************************/
+
+// The mip levels of one cycle, each keeping half the harmonics of the previous one,
+// Q2.30 in the fixed point build
+struct _osc_wavetable {
+	osc_value tab[TABOSC_LEVELS][TABOSC_TABSIZE + 1];
+};
+
+void osc_wavetable_free(osc_wavetable *table)
+{
+	free(table);
+}
+
+#ifndef OSC_FIXED
+
+osc_wavetable *osc_wavetable_new(const osc_sample *cycle, int n)
+{
+	osc_wavetable *table;
+	int i, j, level, harmonics, kept, size = TABOSC_TABSIZE;
+	double *spectrum_real, *spectrum_imag, *real, *imag;
+	double pos, frac, scale;
+
+	if(n < 1) return 0;
+	// the cycle's spectrum, from an FFT big enough to hold all of it
+	while(size < n) size <<= 1;
+	table = (osc_wavetable *)malloc(sizeof(osc_wavetable));
+	spectrum_real = (double *)malloc(sizeof(double) * (size * 2 + TABOSC_TABSIZE * 2));
+	if(!table || !spectrum_real) {
+		free(table);
+		free(spectrum_real);
+		return 0;
+	}
+	spectrum_imag = spectrum_real + size;
+	real = spectrum_imag + size;
+	imag = real + TABOSC_TABSIZE;
+	for(i = 0; i < size; i++){
+		pos = (double) i * n / size;
+		j = pos;
+		frac = pos - j;
+		spectrum_real[i] = cycle[j] + (cycle[(j + 1) % n] - cycle[j]) * frac;
+		spectrum_imag[i] = 0;
+	}
+	osc_fft(spectrum_real, spectrum_imag, size, 0);
+
+	// each level is the inverse FFT of the harmonics it keeps
+	// an n-sample cycle holds nothing above harmonic n/2, what the interpolation
+	// puts there are images of the lower harmonics, so they're left out
+	scale = 1.0 / size;
+	for(level = 0, harmonics = TABOSC_TABSIZE / 4; level < TABOSC_LEVELS; level++, harmonics >>= 1){
+		kept = harmonics < n / 2 ? harmonics : n / 2;
+		for(i = 0; i < TABOSC_TABSIZE; i++) real[i] = imag[i] = 0;
+		real[0] = spectrum_real[0];
+		for(i = 1; i <= kept; i++){
+			real[i] = spectrum_real[i];
+			imag[i] = spectrum_imag[i];
+			real[TABOSC_TABSIZE - i] = spectrum_real[size - i];
+			imag[TABOSC_TABSIZE - i] = spectrum_imag[size - i];
+		}
+		osc_fft(real, imag, TABOSC_TABSIZE, 1);
+		for(i = 0; i < TABOSC_TABSIZE; i++) table->tab[level][i] = real[i] * scale;
+		// copy the first element to the last position for interpolation
+		table->tab[level][TABOSC_TABSIZE] = table->tab[level][0];
+	}
+
+	free(spectrum_real);
+	return table;
+}
+
+void osc_tabOsc_init(osc_tabOsc *x, osc_sample sr)
+{
+	// Initialize phase to 0, there's no table until the host sets one
+	x->phase = 0;
+	x->table = 0;
+
+	// set sampling rate, sampling interval and factor
+	x->sr = sr;
+	x->sifactor = (osc_sample) TABOSC_TABSIZE / x->sr;
+	x->si = 0;
+}
+
+void osc_tabOsc_set_param(osc_tabOsc *x, int param, osc_sample value)
+{
+	switch(param){
+		case OSC_PARAM_SAMPLERATE:
+			x->si *= x->sr / value;
+			x->sr = value;
+			x->sifactor = (osc_sample) TABOSC_TABSIZE / x->sr;
+			break;
+		case OSC_PARAM_PHASE:
+			x->phase = wrap_phase(value * (osc_sample) TABOSC_TABSIZE, TABOSC_TABSIZE);
+			break;
+	}
+}
+
+void osc_tabOsc_render(osc_tabOsc *x, const osc_sample *const *inputs, osc_sample *const *outputs, int n)
+{
+	// Copy signal vector pointers
+	const osc_sample *frequency = inputs[0];
+	const osc_sample *phase_mod = inputs[1];
+	osc_sample *out = outputs[0];
+
+	// Dereference components from the state structure
+	const osc_wavetable *table = x->table;
+	osc_sample si_factor = x->sifactor;
+	osc_sample si = x->si;
+	osc_sample phase = x->phase;
+	// Local variables
+	osc_sample phase_add;
+	int phase_trunc;
+	osc_sample phase_wrap;
+	osc_sample increment, index_frac;
+	const osc_sample *tab;
+	int level, harmonics, index;
+	osc_sample step = (osc_sample) TABOSC_TABSIZE;
+
+	if(!table) {
+		while(n--) *out++ = 0;
+		return;
+	}
+
+	// Perform the DSP loop
+	while(n--){
+		si = *frequency++ * si_factor;
+		// Same wrapping as in osc_varShapesOsc_render()
+		phase_add = ((phase / step) + *phase_mod++);
+		phase_trunc = phase_add;
+		if(phase_add > 0) phase_wrap = phase_add - phase_trunc;
+		else phase_wrap = phase_add - (phase_trunc - 1);
+
+		// pick the richest mip level whose highest harmonic stays below Nyquist
+		increment = si / step;
+		if(increment < 0) increment = -increment;
+		level = 0;
+		harmonics = TABOSC_TABSIZE / 4;
+		while(level < TABOSC_LEVELS - 1 && harmonics * increment > 0.5f) {
+			level++;
+			harmonics >>= 1;
+		}
+
+		// read the level with linear interpolation
+		index_frac = phase_wrap * TABOSC_TABSIZE;
+		// a NaN or huge phase modulation must not read outside the table
+		if(!(index_frac >= 0 && index_frac < TABOSC_TABSIZE)) index_frac = 0;
+		index = index_frac;
+		index_frac -= index;
+		tab = table->tab[level] + index;
+		*out++ = tab[0] + ((tab[1] - tab[0]) * index_frac);
+		phase += si;
+		phase = wrap_phase(phase, step);
+	}
+	// Update the phase variable
+	x->si = si;
+	x->phase = phase;
+}
+#endif
+
+/************************** Fixed point kernels ***************************/
+
+/* Built with OSC_FIXED defined (make OSC_FIXED=1), [powSine~], [randOsc~],
+   [varShapesOsc~], [allOsc~], [sineLoop~], [sineLoopBank~] and [tabOsc~]
+   compute with these instead, for processors that are slow at floating point. The phase is a 32 bit integer a
+   whole cycle wraps around by itself (Q0.32), waveforms are Q2.30, cos() is
+   read from a table and interpolated, and pow() goes through log2() and exp2()
+   tables. Floats are only met where the inputs come in and the outputs go
+   out, and converted so that any machine gets the same integers, so a build
+   renders the same samples bit for bit on x86 and ARM (compare the output of
+   osc_render -checksum). Inputs are clipped to their ranges: frequencies to
+   half the sampling rate, the crossfades, breakpoint, duty cycle and feedback
+   to 0 - 1, the powers to 0 - 32767 and the arrays [tabOsc~] reads to -2 - 2.
+   The band-limited tables of [powSine~] aren't there, bandlimit is ignored */
+#ifdef OSC_FIXED
+
+#define FIXED_TO_SAMPLE(x) ((osc_sample) (x) * (osc_sample) (1.0 / FIXED_ONE))
+
+/* A float into fixed point, scaled and clipped to low - high, NaN gives 0.
+   C leaves converting a float out of an integer's range undefined, and x86
+   and ARM do give different results, so every input goes through here */
+static int32_t fixed_from(osc_sample value, osc_sample scale, int32_t low, int32_t high)
+{
+	value *= scale;
+	if(value >= (osc_sample) high) return high;
+	if(value > (osc_sample) low) return (int32_t) value;
+	if(value <= (osc_sample) low) return low;
+	return 0;
+}
+
+// A phase in cycles into Q0.32, wrapped into one cycle by the integer conversion
+static uint32_t fixed_phase(osc_sample value)
+{
+	value *= FIXED_CYCLE;
+	// past 2^62 (or NaN) there are no fractions of a cycle left anyway
+	if(!(value > (osc_sample) -4611686018427387904.0 && value < (osc_sample) 4611686018427387904.0)) return 0;
+	return (uint32_t) (int64_t) value;
+}
+
+// cos() of a Q0.32 phase, in Q2.30
+static int32_t fixed_cos(uint32_t phase)
+{
+	const int32_t *tab = fixed_cos_tab + (phase >> (32 - FIXED_COS_BITS));
+	int32_t frac = (phase >> (16 - FIXED_COS_BITS)) & 0xffff;
+
+	return tab[0] + (int32_t) (((int64_t) (tab[1] - tab[0]) * frac) >> 16);
+}
+
+// x^y for x in 0 - 1 (Q2.30) and y >= 0 (Q16.16), as 2^(y * log2(x)).
+// log2(x) is never positive, so it's kept negated to stay unsigned
+static int32_t fixed_pow(int32_t x, int32_t y)
+{
+	int shift;
+	uint32_t mantissa, frac, neg_log;
+	uint64_t neg_exp, whole;
+	const int32_t *tab;
+	int32_t value;
+
+	// like pow(), anything to the 0th is 1, 0 included
+	if(y <= 0) return FIXED_ONE;
+	if(x <= 0) return 0;
+	if(x >= FIXED_ONE) return FIXED_ONE;
+
+	// x is 2^-shift times a mantissa of 1 - 2, whose log2 is read from the table
+	shift = __builtin_clz((uint32_t) x) - 1;
+	mantissa = ((uint32_t) x << shift) - FIXED_ONE;
+	tab = fixed_log2_tab + (mantissa >> (30 - FIXED_LOG_BITS));
+	frac = (mantissa >> (14 - FIXED_LOG_BITS)) & 0xffff;
+	neg_log = ((uint32_t) shift << 24) - (tab[0] + (uint32_t) (((uint64_t) (tab[1] - tab[0]) * frac) >> 16));
+
+	// and 2^-(y * -log2(x)) is 2^-whole times 2^-fraction, read from the other one
+	neg_exp = ((uint64_t) neg_log * (uint32_t) y) >> 16;
+	whole = neg_exp >> 24;
+	if(whole > 30) return 0;
+	tab = fixed_exp2_tab + ((neg_exp >> (24 - FIXED_LOG_BITS)) & ((1 << FIXED_LOG_BITS) - 1));
+	frac = neg_exp & 0xffff;
+	value = tab[0] - (int32_t) (((uint64_t) (tab[0] - tab[1]) * frac) >> 16);
+	return value >> whole;
+}
+
+// The crossfade between the cosine and triangle ramps of [randOsc~] and [varShapesOsc~]
+static int32_t fixed_cos_tri(uint32_t cos_phase, int32_t tri_phase, int32_t xfade)
+{
+	return (int32_t) (((((int64_t) fixed_cos(cos_phase) + FIXED_ONE) >> 1) * (FIXED_ONE - xfade) +
+		(int64_t) tri_phase * xfade) >> 30);
+}
+
+void osc_powSine_init(osc_powSine *x, osc_sample sr)
+{
+	// Initialize phase to 0 and sign variable to 1
+	x->phase = 0;
+	x->sign = 1;
+	x->bandlimit = 0;
+
+	// set sampling rate, sampling interval and factor
+	x->sr = sr;
+	x->sifactor = FIXED_CYCLE / x->sr;
+	x->si = 0;
+}
+
+void osc_powSine_set_param(osc_powSine *x, int param, osc_sample value)
+{
+	switch(param){
+		case OSC_PARAM_SAMPLERATE:
+			x->sr = value;
+			x->sifactor = FIXED_CYCLE / x->sr;
+			break;
+		case OSC_PARAM_PHASE:
+			x->phase = fixed_phase(value);
+			break;
+	}
+}
+
+void osc_powSine_render(osc_powSine *x, const osc_sample *const *inputs, osc_sample *const *outputs, int n)
+{
+	// Copy signal vector pointers
+	const osc_sample *frequency = inputs[0];
+	const osc_sample *phase_mod = inputs[1];
+	const osc_sample *power = inputs[2];
+	osc_sample *out = outputs[0];
+
+	// Dereference components from the state structure
+	osc_sample si_factor = x->sifactor;
+	uint32_t phase = x->phase;
+	int sign = x->sign;
+	// Local variables
+	uint32_t phase_wrap;
+	int32_t si, base;
+
+	// Perform the DSP loop
+	while(n--){
+		si = fixed_from(*frequency++, si_factor, INT32_MIN, INT32_MAX);
+		phase_wrap = phase + fixed_phase(*phase_mod++);
+		if(phase_wrap > 0x80000000u) sign = 1;
+		else sign = -1;
+		// (1 - cos()) / 2 of the doubled phase, which wraps by itself
+		base = (int32_t) ((FIXED_ONE - (int64_t) fixed_cos(phase_wrap << 1)) >> 1);
+		*out++ = FIXED_TO_SAMPLE(fixed_pow(base, fixed_from(*power++, FIXED_POWER_ONE, 0, INT32_MAX)) * sign);
+		phase += si;
+	}
+	// Update the phase and sign variables
+	x->phase = phase;
+	x->sign = sign;
+}
+
+void osc_randOsc_init(osc_randOsc *x, osc_sample sr)
+{
+	// seed every instance differently, like [noise~] does
+	static int init = 307;
+
+	// Initialize phase and random samples to 0
+	x->phase = 0;
+	x->random_sample = 0;
+	x->old_random_sample = 0;
+	x->randval = (init *= 1319);
+
+	// set sampling rate, sampling interval and factor
+	x->sr = sr;
+	x->sifactor = FIXED_CYCLE / x->sr;
+	x->si = 0;
+}
+
+void osc_randOsc_set_param(osc_randOsc *x, int param, osc_sample value)
+{
+	switch(param){
+		case OSC_PARAM_SAMPLERATE:
+			x->sr = value;
+			x->sifactor = FIXED_CYCLE / x->sr;
+			break;
+		case OSC_PARAM_PHASE:
+			x->phase = fixed_phase(value);
+			break;
+		case OSC_PARAM_SEED:
+			x->randval = fixed_from(value, 1, INT32_MIN, INT32_MAX);
+			break;
+	}
+}
+
+void osc_randOsc_render(osc_randOsc *x, const osc_sample *const *inputs, osc_sample *const *outputs, int n)
+{
+	// Copy signal vector pointers
+	const osc_sample *frequency = inputs[0];
+	const osc_sample *xfade = inputs[1];
+	const osc_sample *power = inputs[2];
+	osc_sample *out = outputs[0];
+
+	// Dereference components from the state structure
+	osc_sample si_factor = x->sifactor;
+	uint32_t phase = x->phase;
+	int32_t random_sample = x->random_sample;
+	int32_t old_random_sample = x->old_random_sample;
+	uint32_t randval = x->randval;
+	// Local variables
+	int32_t si, noise, xfade_local;
+	uint32_t cos_phase;
+	int32_t tri_phase, value;
+	// Variables for scale and offset
+	int32_t scale, offset;
+	int32_t random_bipolar, old_random_bipolar;
+	int32_t abs_random_bipolar, abs_old_random_bipolar;
+	int32_t max_sample, max_absolute_sample;
+
+	// Perform the DSP loop
+	while(n--){
+		// The same generator as the floating point kernel, 0 - 1 in Q2.30
+		noise = (randval & 0x7fffffff) >> 1;
+		randval = randval * 435898247u + 382842987u;
+		xfade_local = fixed_from(*xfade++, FIXED_ONE, 0, FIXED_ONE);
+		// Set scale and offset values according to random samples
+		scale = random_sample - old_random_sample;
+		if(scale < 0) scale = -scale;
+		random_bipolar = (random_sample * 2) - FIXED_ONE;
+		old_random_bipolar = (old_random_sample * 2) - FIXED_ONE;
+		abs_random_bipolar = random_bipolar < 0 ? -random_bipolar : random_bipolar;
+		abs_old_random_bipolar = old_random_bipolar < 0 ? -old_random_bipolar : old_random_bipolar;
+		if(abs_random_bipolar > abs_old_random_bipolar) max_absolute_sample = abs_random_bipolar;
+		else max_absolute_sample = abs_old_random_bipolar;
+		offset = max_absolute_sample - scale;
+		if(random_bipolar > old_random_bipolar) max_sample = random_bipolar;
+		else max_sample = old_random_bipolar;
+		if(!(max_sample > scale)) offset = -offset;
+		// Phase increment
+		si = fixed_from(*frequency++, si_factor, INT32_MIN, INT32_MAX);
+		// Cosine and triangle values
+		if(random_sample > old_random_sample) {
+			cos_phase = (phase >> 1) + 0x80000000u;
+			tri_phase = phase >> 2;
+		}
+		else {
+			cos_phase = phase >> 1;
+			tri_phase = FIXED_ONE - (phase >> 2);
+		}
+		value = (fixed_pow(fixed_cos_tri(cos_phase, tri_phase, xfade_local),
+			fixed_from(*power++, FIXED_POWER_ONE, 0, INT32_MAX)) * 2) - FIXED_ONE;
+		*out++ = FIXED_TO_SAMPLE((int32_t) (((int64_t) value * scale) >> 30) + offset);
+		// a new random target at the end of each cycle
+		if(si > 0 && phase + si < phase) {
+			old_random_sample = random_sample;
+			random_sample = noise;
+		}
+		phase += si;
+	}
+
+	// Update the phase, random samples and generator
+	x->phase = phase;
+	x->random_sample = random_sample;
+	x->old_random_sample = old_random_sample;
+	x->randval = randval;
+}
+
+void osc_varShapesOsc_init(osc_varShapesOsc *x, osc_sample sr)
+{
+	// Initialize phase to 0
+	x->phase = 0;
+
+	// set sampling rate, sampling interval and factor
+	x->sr = sr;
+	x->sifactor = FIXED_CYCLE / x->sr;
+	x->si = 0;
+}
+
+void osc_varShapesOsc_set_param(osc_varShapesOsc *x, int param, osc_sample value)
+{
+	switch(param){
+		case OSC_PARAM_SAMPLERATE:
+			x->sr = value;
+			x->sifactor = FIXED_CYCLE / x->sr;
+			break;
+		case OSC_PARAM_PHASE:
+			x->phase = fixed_phase(value);
+			break;
+	}
+}
+
+void osc_varShapesOsc_render(osc_varShapesOsc *x, const osc_sample *const *inputs, osc_sample *const *outputs, int n)
+{
+	// Copy signal vector pointers
+	const osc_sample *frequency = inputs[0];
+	const osc_sample *phase_mod = inputs[1];
+	const osc_sample *xfade = inputs[2];
+	const osc_sample *breakpoint = inputs[3];
+	const osc_sample *rise_power = inputs[4];
+	const osc_sample *fall_power = inputs[5];
+	osc_sample *out = outputs[0];
+
+	// Dereference components from the state structure
+	osc_sample si_factor = x->sifactor;
+	uint32_t phase = x->phase;
+	// Local variables
+	int32_t si, xfade_local, tri_phase, power_local, value;
+	uint32_t phase_wrap, cos_phase;
+	// the breakpoint and the ramps up to it and down from it are Q0.32, with
+	// room for a breakpoint of a whole cycle
+	uint64_t breakpoint_local, ramp;
+
+	// Perform the DSP loop
+	while(n--){
+		breakpoint_local = (uint64_t) fixed_from(*breakpoint++, FIXED_ONE, 0, FIXED_ONE) << 2;
+		xfade_local = fixed_from(*xfade++, FIXED_ONE, 0, FIXED_ONE);
+		si = fixed_from(*frequency++, si_factor, INT32_MIN, INT32_MAX);
+		phase_wrap = phase + fixed_phase(*phase_mod++);
+		// the phase is always below a breakpoint of 1, so the fall always has a length
+		if(phase_wrap < breakpoint_local) {
+			ramp = ((uint64_t) phase_wrap << 32) / breakpoint_local;
+			cos_phase = (uint32_t) (ramp >> 1) + 0x80000000u;
+			tri_phase = ramp >> 2;
+			power_local = fixed_from(*rise_power, FIXED_POWER_ONE, 0, INT32_MAX);
+		}
+		else {
+			ramp = ((phase_wrap - breakpoint_local) << 32) / ((1ull << 32) - breakpoint_local);
+			cos_phase = ramp >> 1;
+			tri_phase = FIXED_ONE - (int32_t) (ramp >> 2);
+			power_local = fixed_from(*fall_power, FIXED_POWER_ONE, 0, INT32_MAX);
+		}
+		rise_power++;
+		fall_power++;
+		value = fixed_pow(fixed_cos_tri(cos_phase, tri_phase, xfade_local), power_local);
+		*out++ = FIXED_TO_SAMPLE((value * 2) - FIXED_ONE);
+		phase += si;
+	}
+	// Update the phase variable
+	x->phase = phase;
+}
+
+void osc_allOsc_init(osc_allOsc *x, osc_sample sr)
+{
+	// Initialize phase to 0
+	x->phase = 0;
+
+	// set sampling rate, sampling interval and factor
+	x->sr = sr;
+	x->sifactor = FIXED_CYCLE / x->sr;
+	x->si = 0;
+}
+
+void osc_allOsc_set_param(osc_allOsc *x, int param, osc_sample value)
+{
+	switch(param){
+		case OSC_PARAM_SAMPLERATE:
+			x->sr = value;
+			x->sifactor = FIXED_CYCLE / x->sr;
+			break;
+		case OSC_PARAM_PHASE:
+			x->phase = fixed_phase(value);
+			break;
+	}
+}
+
+void osc_allOsc_render(osc_allOsc *x, const osc_sample *const *inputs, osc_sample *const *outputs, int n)
+{
+	// Copy signal vector pointers
+	const osc_sample *frequency = inputs[0];
+	const osc_sample *phase_mod = inputs[1];
+	const osc_sample *duty_cycle = inputs[2];
+	osc_sample *out1 = outputs[0];
+	osc_sample *out2 = outputs[1];
+	osc_sample *out3 = outputs[2];
+	osc_sample *out4 = outputs[3];
+
+	// Dereference components from the state structure
+	osc_sample si_factor = x->sifactor;
+	uint32_t phase = x->phase;
+	// Local variables
+	int32_t si;
+	uint32_t phase_wrap, tri_phase;
+	uint64_t duty_cycle_local; // Q0.32, with room for a duty cycle of 1
+
+	// Perform the DSP loop
+	while(n--){
+		si = fixed_from(*frequency++, si_factor, INT32_MIN, INT32_MAX);
+		duty_cycle_local = (uint64_t) fixed_from(*duty_cycle++, FIXED_ONE, 0, FIXED_ONE) << 2;
+		phase_wrap = phase + fixed_phase(*phase_mod++);
+		// the triangle is the distance to the start of the cycle, up to half a cycle
+		tri_phase = phase_wrap < 0x80000000u ? phase_wrap : 0u - phase_wrap;
+
+		// cosine (starting from -1 to be in phase with the triangle), triangle,
+		// sawtooth and square wave values, to the respective outlets
+		*out1++ = FIXED_TO_SAMPLE(-fixed_cos(phase_wrap));
+		*out2++ = FIXED_TO_SAMPLE((int32_t) ((int64_t) tri_phase - FIXED_ONE));
+		*out3++ = FIXED_TO_SAMPLE((int32_t) (phase_wrap >> 1) - FIXED_ONE);
+		*out4++ = phase_wrap < duty_cycle_local ? -1 : 1;
+		phase += si;
+	}
+	// Update the phase variable
+	x->phase = phase;
+}
+
+void osc_sineLoop_init(osc_sineLoop *x, osc_sample sr)
+{
+	// Initialize phase and last sample to 0
+	x->phase = 0;
+	x->last_sample = 0;
+
+	// set sampling rate, sampling interval and factor
+	x->sr = sr;
+	x->sifactor = FIXED_CYCLE / x->sr;
+	x->si = 0;
+}
+
+void osc_sineLoop_set_param(osc_sineLoop *x, int param, osc_sample value)
+{
+	switch(param){
+		case OSC_PARAM_SAMPLERATE:
+			x->sr = value;
+			x->sifactor = FIXED_CYCLE / x->sr;
+			break;
+		case OSC_PARAM_PHASE:
+			x->phase = fixed_phase(value);
+			break;
+	}
+}
+
+void osc_sineLoop_render(osc_sineLoop *x, const osc_sample *const *inputs, osc_sample *const *outputs, int n)
+{
+	// Copy signal vector pointers
+	const osc_sample *frequency = inputs[0];
+	const osc_sample *fb_amount = inputs[1];
+	osc_sample *out = outputs[0];
+
+	// Dereference components from the state structure
+	int32_t last_sample = x->last_sample;
+	osc_sample si_factor = x->sifactor;
+	uint32_t phase = x->phase;
+	// Local variables
+	int32_t si, feedback;
+
+	// Perform the DSP loop
+	while(n--){
+		si = fixed_from(*frequency++, si_factor, INT32_MIN, INT32_MAX);
+		feedback = fixed_from(*fb_amount++, FIXED_ONE, 0, FIXED_ONE);
+		// add the last sample times the feedback to the phase, in cycles (Q4.60 >> 28
+		// is Q0.32), and a whole cycle of it wraps around by itself
+		last_sample = fixed_cos(phase + (uint32_t) (((int64_t) last_sample * feedback) >> 28));
+		*out++ = FIXED_TO_SAMPLE(last_sample);
+		phase += si;
+	}
+	// Update the phase and last_sample variables
+	x->phase = phase;
+	x->last_sample = last_sample;
+}
+
+void osc_sineLoopBank_init(osc_sineLoopBank *x, osc_sample sr, int nvoices)
+{
+	if(nvoices < 1) nvoices = 1;
+	if(nvoices > OSC_SINELOOPBANK_MAXVOICES) nvoices = OSC_SINELOOPBANK_MAXVOICES;
+	x->nvoices = nvoices;
+
+	// all voices, including the ones past nvoices filling up the last lanes, start
+	// silent at the start of their cycle
+	memset(x->frequency, 0, sizeof(x->frequency));
+	memset(x->feedback, 0, sizeof(x->feedback));
+	memset(x->phase, 0, sizeof(x->phase));
+	memset(x->last_sample, 0, sizeof(x->last_sample));
+
+	x->sr = sr;
+	x->sifactor = FIXED_CYCLE / x->sr;
+}
+
+void osc_sineLoopBank_set_param(osc_sineLoopBank *x, int voice, int param, osc_sample value)
+{
+	int first = voice, last = voice + 1;
+
+	if(param == OSC_PARAM_SAMPLERATE) {
+		x->sr = value;
+		x->sifactor = FIXED_CYCLE / x->sr;
+		return;
+	}
+	if(voice < 0) {
+		first = 0;
+		last = x->nvoices;
+	}
+	else if(voice >= x->nvoices) return;
+
+	for(voice = first; voice < last; voice++){
+		switch(param){
+			case OSC_PARAM_PHASE:
+				x->phase[voice] = fixed_phase(value);
+				break;
+			case OSC_PARAM_FREQUENCY:
+				x->frequency[voice] = value;
+				break;
+			case OSC_PARAM_FEEDBACK:
+				x->feedback[voice] = fixed_from(value, FIXED_ONE, 0, FIXED_ONE);
+				break;
+		}
+	}
+}
+
+void osc_sineLoopBank_render(osc_sineLoopBank *x, const osc_sample *ratio, osc_sample *const *outputs, osc_sample *mix, int n)
+{
+	osc_sample si_factor = x->sifactor;
+	uint32_t *phase = x->phase;
+	int32_t *last_sample = x->last_sample;
+	const osc_sample *frequency = x->frequency;
+	const int32_t *feedback = x->feedback;
+	// the voices past the last one are rendered too and thrown away, as in the
+	// floating point kernel
+	int nvoices = x->nvoices;
+	int nlanes = (nvoices + OSC_SINELOOPBANK_LANES - 1) / OSC_SINELOOPBANK_LANES * OSC_SINELOOPBANK_LANES;
+	uint32_t phase_local[OSC_SINELOOPBANK_MAXVOICES];
+	osc_sample ratio_factor;
+	int64_t sum;
+	int voice, i;
+
+	for(i = 0; i < n; i++){
+		// one product of floats per voice, the frequency and this, which
+		// leaves the compiler nothing to reorder
+		ratio_factor = ratio[i] * si_factor;
+		// The same steps as the fixed point osc_sineLoop_render(), with the same
+		// results at a ratio of 1. The phases are integer sums that run on a
+		// vector of voices at a time, the cosines are table look-ups
+		for(voice = 0; voice < nlanes; voice++)
+			phase_local[voice] = phase[voice] + (uint32_t) (((int64_t) last_sample[voice] * feedback[voice]) >> 28);
+		for(voice = 0; voice < nlanes; voice++){
+			last_sample[voice] = fixed_cos(phase_local[voice]);
+			phase[voice] += fixed_from(frequency[voice], ratio_factor, INT32_MIN, INT32_MAX);
+		}
+
+		if(outputs) {
+			for(voice = 0; voice < nvoices; voice++) outputs[voice][i] = FIXED_TO_SAMPLE(last_sample[voice]);
+		}
+		if(mix) {
+			// summed as integers, so the mix doesn't depend on the order of the sums
+			for(voice = 0, sum = 0; voice < nvoices; voice++) sum += last_sample[voice];
+			mix[i] = FIXED_TO_SAMPLE(sum);
+		}
+	}
+}
+
+/* In-place radix-2 complex FFT of 2^bits points in Q8.24, so that every machine
+   builds the same [tabOsc~] tables. The twiddle factors are read from the cosine
+   table, and every pass of the forward FFT is halved, so it stays in range and
+   the spectrum comes out divided by its size. The inverse one isn't, the sums
+   of the harmonics of an array clipped to -2 - 2 stay below 2^31 in Q8.24 */
+static void fixed_fft(int32_t *real, int32_t *imag, int bits, int inverse)
+{
+	int n = 1 << bits, i, j, k, bit, len, half, shift;
+	uint32_t angle;
+	int32_t w_real, w_imag, tmp;
+	int64_t v_real, v_imag;
+
+	// bit-reversal permutation
+	for(i = 1, j = 0; i < n; i++){
+		for(bit = n >> 1; j & bit; bit >>= 1) j ^= bit;
+		j ^= bit;
+		if(i < j) {
+			tmp = real[i]; real[i] = real[j]; real[j] = tmp;
+			tmp = imag[i]; imag[i] = imag[j]; imag[j] = tmp;
+		}
+	}
+	// butterflies, shift turns k into a Q0.32 angle of k / len cycles
+	for(len = 2, shift = 31; len <= n; len <<= 1, shift--){
+		half = len >> 1;
+		for(k = 0; k < half; k++){
+			// sin() is cos() a quarter cycle earlier
+			angle = (uint32_t) k << shift;
+			w_real = fixed_cos(angle);
+			w_imag = fixed_cos(angle - 0x40000000u);
+			if(!inverse) w_imag = -w_imag;
+			for(i = k; i < n; i += len){
+				v_real = ((int64_t) real[i + half] * w_real - (int64_t) imag[i + half] * w_imag) >> 30;
+				v_imag = ((int64_t) real[i + half] * w_imag + (int64_t) imag[i + half] * w_real) >> 30;
+				if(inverse) {
+					real[i + half] = (int32_t) (real[i] - v_real);
+					imag[i + half] = (int32_t) (imag[i] - v_imag);
+					real[i] = (int32_t) (real[i] + v_real);
+					imag[i] = (int32_t) (imag[i] + v_imag);
+				}
+				else {
+					real[i + half] = (int32_t) ((real[i] - v_real) >> 1);
+					imag[i + half] = (int32_t) ((imag[i] - v_imag) >> 1);
+					real[i] = (int32_t) ((real[i] + v_real) >> 1);
+					imag[i] = (int32_t) ((imag[i] + v_imag) >> 1);
+				}
+			}
+		}
+	}
+}
+
+// The same mip levels as the floating point osc_wavetable_new(), with fixed_fft()
+osc_wavetable *osc_wavetable_new(const osc_sample *cycle, int n)
+{
+	osc_wavetable *table;
+	int i, j, level, harmonics, kept, bits = TABOSC_TABBITS, size;
+	int32_t *spectrum_real, *spectrum_imag, *real, *imag, left, right, value;
+	int64_t pos;
+
+	if(n < 1) return 0;
+	// the cycle's spectrum, from an FFT big enough to hold all of it
+	while((1 << bits) < n) bits++;
+	size = 1 << bits;
+	table = (osc_wavetable *)malloc(sizeof(osc_wavetable));
+	spectrum_real = (int32_t *)malloc(sizeof(int32_t) * (size * 2 + TABOSC_TABSIZE * 2));
+	if(!table || !spectrum_real) {
+		free(table);
+		free(spectrum_real);
+		return 0;
+	}
+	spectrum_imag = spectrum_real + size;
+	real = spectrum_imag + size;
+	imag = real + TABOSC_TABSIZE;
+	for(i = 0; i < size; i++){
+		// the position in the cycle, in 1 / size of a sample
+		pos = (int64_t) i * n;
+		j = pos >> bits;
+		left = fixed_from(cycle[j], FIXED_FFT_ONE, -2 * FIXED_FFT_ONE, 2 * FIXED_FFT_ONE);
+		right = fixed_from(cycle[(j + 1) % n], FIXED_FFT_ONE, -2 * FIXED_FFT_ONE, 2 * FIXED_FFT_ONE);
+		spectrum_real[i] = left + (int32_t) (((int64_t) (right - left) * (pos & (size - 1))) >> bits);
+		spectrum_imag[i] = 0;
+	}
+	fixed_fft(spectrum_real, spectrum_imag, bits, 0);
+
+	// each level is the inverse FFT of the harmonics it keeps, see osc_wavetable_new()
+	for(level = 0, harmonics = TABOSC_TABSIZE / 4; level < TABOSC_LEVELS; level++, harmonics >>= 1){
+		kept = harmonics < n / 2 ? harmonics : n / 2;
+		for(i = 0; i < TABOSC_TABSIZE; i++) real[i] = imag[i] = 0;
+		real[0] = spectrum_real[0];
+		for(i = 1; i <= kept; i++){
+			real[i] = spectrum_real[i];
+			imag[i] = spectrum_imag[i];
+			real[TABOSC_TABSIZE - i] = spectrum_real[size - i];
+			imag[TABOSC_TABSIZE - i] = spectrum_imag[size - i];
+		}
+		fixed_fft(real, imag, TABOSC_TABBITS, 1);
+		// into Q2.30, clipped to its range
+		for(i = 0; i < TABOSC_TABSIZE; i++){
+			value = real[i];
+			if(value >= 2 * FIXED_FFT_ONE) value = 2 * FIXED_FFT_ONE - 1;
+			else if(value < -2 * FIXED_FFT_ONE) value = -2 * FIXED_FFT_ONE;
+			table->tab[level][i] = value * (FIXED_ONE / FIXED_FFT_ONE);
+		}
+		// copy the first element to the last position for interpolation
+		table->tab[level][TABOSC_TABSIZE] = table->tab[level][0];
+	}
+
+	free(spectrum_real);
+	return table;
+}
+
+void osc_tabOsc_init(osc_tabOsc *x, osc_sample sr)
+{
+	// Initialize phase to 0, there's no table until the host sets one
+	x->phase = 0;
+	x->table = 0;
+
+	// set sampling rate, sampling interval and factor
+	x->sr = sr;
+	x->sifactor = FIXED_CYCLE / x->sr;
+	x->si = 0;
+}
+
+void osc_tabOsc_set_param(osc_tabOsc *x, int param, osc_sample value)
+{
+	switch(param){
+		case OSC_PARAM_SAMPLERATE:
+			x->sr = value;
+			x->sifactor = FIXED_CYCLE / x->sr;
+			break;
+		case OSC_PARAM_PHASE:
+			x->phase = fixed_phase(value);
+			break;
+	}
+}
+
+void osc_tabOsc_render(osc_tabOsc *x, const osc_sample *const *inputs, osc_sample *const *outputs, int n)
+{
+	// Copy signal vector pointers
+	const osc_sample *frequency = inputs[0];
+	const osc_sample *phase_mod = inputs[1];
+	osc_sample *out = outputs[0];
+
+	// Dereference components from the state structure
+	const osc_wavetable *table = x->table;
+	osc_sample si_factor = x->sifactor;
+	uint32_t phase = x->phase;
+	// Local variables
+	uint32_t phase_wrap, increment;
+	int32_t si, frac;
+	const int32_t *tab;
+	int level, harmonics;
+
+	if(!table) {
+		while(n--) *out++ = 0;
+		return;
+	}
+
+	// Perform the DSP loop
+	while(n--){
+		si = fixed_from(*frequency++, si_factor, INT32_MIN, INT32_MAX);
+		phase_wrap = phase + fixed_phase(*phase_mod++);
+
+		// pick the richest mip level whose highest harmonic stays below Nyquist,
+		// half a cycle (2^31) per sample
+		increment = si < 0 ? -(uint32_t) si : (uint32_t) si;
+		level = 0;
+		harmonics = TABOSC_TABSIZE / 4;
+		while(level < TABOSC_LEVELS - 1 && (uint64_t) harmonics * increment > 0x80000000u) {
+			level++;
+			harmonics >>= 1;
+		}
+
+		// read the level with linear interpolation, the top bits of the phase
+		// are the index and the next 16 the fraction
+		tab = table->tab[level] + (phase_wrap >> (32 - TABOSC_TABBITS));
+		frac = (phase_wrap >> (16 - TABOSC_TABBITS)) & 0xffff;
+		*out++ = FIXED_TO_SAMPLE(tab[0] + (int32_t) ((((int64_t) tab[1] - tab[0]) * frac) >> 16));
+		phase += si;
+	}
+	// Update the phase variable
+	x->phase = phase;
+}
+
+#endif // OSC_FIXED
+
+/***************************** generic access *****************************/
+
+// Wrappers taking a void pointer to the state, for the osc_types table
+#define OSC_TYPE(name) \
+	static void name##_init_generic(void *x, osc_sample sr) \
+		{ osc_##name##_init((osc_##name *) x, sr); } \
+	static void name##_set_param_generic(void *x, int param, osc_sample value) \
+		{ osc_##name##_set_param((osc_##name *) x, param, value); } \
+	static void name##_render_generic(void *x, const osc_sample *const *in, osc_sample *const *out, int n) \
+		{ osc_##name##_render((osc_##name *) x, in, out, n); }
+
+OSC_TYPE(powSine)
+OSC_TYPE(randOsc)
+OSC_TYPE(varShapesOsc)
+OSC_TYPE(allOsc)
+OSC_TYPE(sineLoop)
+OSC_TYPE(tabOsc)
+
+static const char *const powSine_inputs[] = { "frequency", "phase_mod", "power" };
+static const char *const randOsc_inputs[] = { "frequency", "xfade", "power" };
+static const char *const varShapesOsc_inputs[] = { "frequency", "phase_mod", "xfade", "breakpoint", "rise_power", "fall_power" };
+static const char *const allOsc_inputs[] = { "frequency", "phase_mod", "duty_cycle" };
+static const char *const sineLoop_inputs[] = { "frequency", "fb_amount" };
+static const char *const tabOsc_inputs[] = { "frequency", "phase_mod" };
+
+#define OSC_TYPE_FIELDS(name, upper) \
+	#name, OSC_##upper##_INPUTS, OSC_##upper##_OUTPUTS, name##_inputs, sizeof(osc_##name), \
+		name##_init_generic, name##_set_param_generic
+#define OSC_TYPE_ENTRY(name, upper, separate) \
+	{ OSC_TYPE_FIELDS(name, upper), name##_render_generic, separate }
+
+/* The same oscillators with the restrict-qualified render routines, for vectors
+   that don't overlap. [sineLoop~] has none, each of its samples is computed from
+   the one before, and neither do the fixed point kernels and [tabOsc~], whose
+   table reads wouldn't run on vectors */
+#ifndef OSC_FIXED
+#define OSC_TYPE_SEPARATE(name, upper) \
+	static void name##_render_separate_generic(void *x, const osc_sample *const *in, osc_sample *const *out, int n) \
+		{ name##_render_separate((osc_##name *) x, in, out, n); } \
+	static const osc_type name##_separate_type = { OSC_TYPE_FIELDS(name, upper), name##_render_separate_generic, 0 };
+
+OSC_TYPE_SEPARATE(powSine, POWSINE)
+OSC_TYPE_SEPARATE(randOsc, RANDOSC)
+OSC_TYPE_SEPARATE(varShapesOsc, VARSHAPESOSC)
+OSC_TYPE_SEPARATE(allOsc, ALLOSC)
+#define OSC_SEPARATE(name) (&name##_separate_type)
+#else
+#define OSC_SEPARATE(name) 0
+#endif
+
+const osc_type osc_types[] = {
+	OSC_TYPE_ENTRY(powSine, POWSINE, OSC_SEPARATE(powSine)),
+	OSC_TYPE_ENTRY(randOsc, RANDOSC, OSC_SEPARATE(randOsc)),
+	OSC_TYPE_ENTRY(varShapesOsc, VARSHAPESOSC, OSC_SEPARATE(varShapesOsc)),
+	OSC_TYPE_ENTRY(allOsc, ALLOSC, OSC_SEPARATE(allOsc)),
+	OSC_TYPE_ENTRY(sineLoop, SINELOOP, 0),
+	{ 0, 0, 0, 0, 0, 0, 0, 0, 0 }
+};
+
+const osc_type osc_tabOsc_type = OSC_TYPE_ENTRY(tabOsc, TABOSC, 0);
+
+const osc_type *osc_type_find(const char *name)
+{
+	const osc_type *type;
+	int len = strlen(name);
+
+	// accept the Pd object's name with the tilde too
+	if(len && name[len - 1] == '~') len--;
+	for(type = osc_types; type->name; type++)
+		if((int) strlen(type->name) == len && !strncmp(type->name, name, len)) return type;
+	return 0;
+}
+
+// Whether two vectors of n samples share any samples
+static int vectors_overlap(const osc_sample *a, const osc_sample *b, int n)
+{
+	uintptr_t start_a = (uintptr_t) a, start_b = (uintptr_t) b;
+	uintptr_t bytes = (uintptr_t) n * sizeof(osc_sample);
+
+	return start_a < start_b + bytes && start_b < start_a + bytes;
+}
+
+/* Pd hands an outlet the vector of an inlet whenever it can, so an output often
+   overwrites an input as it's rendered. Inputs sharing a vector are fine, they're
+   only read, but an output must overlap nothing else for the separate kernels */
+const osc_type *osc_type_select(const osc_type *type, const osc_sample *const *inputs, osc_sample *const *outputs, int n)
+{
+	int i, j;
+
+	if(!type->separate) return type;
+	for(i = 0; i < type->noutputs; i++){
+		for(j = 0; j < type->ninputs; j++)
+			if(vectors_overlap(outputs[i], inputs[j], n)) return type;
+		for(j = 0; j < i; j++)
+			if(vectors_overlap(outputs[i], outputs[j], n)) return type;
+	}
+	return type->separate;
+}
+
+/****************************** Event queue ******************************/
+
+/* The producer only writes head and the consumer only writes tail. Each side
+   reads the other's index with acquire and publishes its own with release, so
+   an event's contents are visible before the index that hands it over */
+#define OSC_LOAD(ptr) __atomic_load_n((ptr), __ATOMIC_ACQUIRE)
+#define OSC_STORE(ptr, value) __atomic_store_n((ptr), (value), __ATOMIC_RELEASE)
+
+void osc_queue_init(osc_queue *q, osc_event *events)
+{
+	q->head = q->tail = 0;
+	q->events = events;
+}
+
+int osc_queue_push(osc_queue *q, const osc_event *event)
+{
+	unsigned int head = q->head;
+
+	if(head - OSC_LOAD(&q->tail) >= OSC_QUEUE_SIZE) return 0;
+	q->events[head & (OSC_QUEUE_SIZE - 1)] = *event;
+	OSC_STORE(&q->head, head + 1);
+	return 1;
+}
+
+osc_event *osc_queue_front(osc_queue *q)
+{
+	unsigned int tail = q->tail;
+
+	if(OSC_LOAD(&q->head) == tail) return 0;
+	return &q->events[tail & (OSC_QUEUE_SIZE - 1)];
+}
+
+void osc_queue_pop(osc_queue *q)
+{
+	OSC_STORE(&q->tail, q->tail + 1);
+}
+
+// Apply a queued event, on the audio thread
+static void queue_apply(const osc_type *type, void *x, osc_decimator *d, const osc_event *event)
+{
+	if(event->param == OSC_PARAM_DECIMATE) {
+		if(d) osc_decimator_init(d, event->value[0]);
+		return;
+	}
+	type->set_param(x, event->param, event->value[0]);
+	// a decimator's next point was computed from the phase before the reset
+	if(d && event->param == OSC_PARAM_PHASE) d->left = d->primed = 0;
+}
+
+// Render through the decimator, if there is one and it's on
+static void queue_render_segment(const osc_type *type, void *x, osc_decimator *d, const osc_sample *const *inputs, osc_sample *const *outputs, int n)
+{
+	if(d && d->factor) osc_decimator_render(d, type, x, inputs, outputs, n);
+	else type->render(x, inputs, outputs, n);
+}
+
+void osc_queue_render(osc_queue *q, const osc_type *type, void *x, osc_decimator *d, const osc_sample *const *inputs, osc_sample *const *outputs, int n)
+{
+	const osc_sample *in[OSC_MAX_INPUTS];
+	osc_sample *out[OSC_MAX_OUTPUTS];
+	osc_event *event;
+	int done = 0, end, i;
+
+	// the common case, nothing has been sent during the last block
+	if(!osc_queue_front(q)) {
+		queue_render_segment(type, x, d, inputs, outputs, n);
+		return;
+	}
+
+	while(done < n){
+		// apply the events that are due, and render up to the next one
+		end = n;
+		while((event = osc_queue_front(q))) {
+			if(event->offset > done) {
+				if(event->offset < n) end = event->offset;
+				break;
+			}
+			queue_apply(type, x, d, event);
+			osc_queue_pop(q);
+		}
+		for(i = 0; i < type->ninputs; i++) in[i] = inputs[i] + done;
+		for(i = 0; i < type->noutputs; i++) out[i] = outputs[i] + done;
+		queue_render_segment(type, x, d, in, out, end - done);
+		done = end;
+	}
+	// the rest is for after the end of this block
+	while((event = osc_queue_front(q))) {
+		queue_apply(type, x, d, event);
+		osc_queue_pop(q);
+	}
+}
+
+/*************************** Decimated rendering ***************************/
+
+void osc_decimator_init(osc_decimator *d, int factor)
+{
+	// 1 is every sample anyway
+	d->factor = factor == 1 ? 0 : factor;
+	if(d->factor < -1) d->factor = -1;
+	d->left = d->primed = 0;
+}
+
+/* The oscillator computes one point at a time. The kernels output the sample
+   at the phase they start from, so the phase is first moved to the next point
+   by rendering a single sample with the frequency multiplied by the number of
+   samples to it, and the point is then read by rendering one more at zero
+   frequency. It's kept one point ahead of the output, which ramps from the
+   point at the start of each segment to the one at its end, so the
+   interpolation adds no delay */
+void osc_decimator_render(osc_decimator *d, const osc_type *type, void *x, const osc_sample *const *inputs, osc_sample *const *outputs, int n)
+{
+	const osc_sample *in[OSC_MAX_INPUTS];
+	osc_sample *out[OSC_MAX_OUTPUTS];
+	osc_sample point[OSC_MAX_OUTPUTS], frequency, value, inc;
+	int i, j, count, factor, done = 0;
+
+	in[0] = &frequency;
+	for(i = 0; i < type->noutputs; i++) out[i] = &point[i];
+
+	while(done < n){
+		if(!d->left) {
+			// all inputs but the frequency are read at the point only
+			for(i = 1; i < type->ninputs; i++) in[i] = inputs[i] + done;
+			// once per block holds until the end of this one
+			factor = d->factor < 0 ? n - done : d->factor;
+			if(!d->primed) {
+				// the value at the current phase, without moving it
+				frequency = 0;
+				type->render(x, in, out, 1);
+				for(i = 0; i < type->noutputs; i++) d->value[i] = point[i];
+				d->primed = 1;
+			}
+			// move the phase to the end of the segment, and read the point there
+			frequency = inputs[0][done] * factor;
+			type->render(x, in, out, 1);
+			frequency = 0;
+			type->render(x, in, out, 1);
+			for(i = 0; i < type->noutputs; i++){
+				// nothing ramps from a point that isn't finite, the segment starts at the new one
+				if(!isfinite(d->value[i])) d->value[i] = point[i];
+				d->next[i] = point[i];
+				d->inc[i] = d->factor < 0 ? 0 : (point[i] - d->value[i]) / factor;
+			}
+			d->left = factor;
+		}
+		count = d->left < n - done ? d->left : n - done;
+		for(i = 0; i < type->noutputs; i++){
+			value = d->value[i];
+			inc = d->inc[i];
+			for(j = 0; j < count; j++){
+				outputs[i][done + j] = value;
+				value += inc;
+			}
+			d->value[i] = value;
+		}
+		d->left -= count;
+		done += count;
+		// land on the point exactly, so rounding doesn't add up
+		if(!d->left) for(i = 0; i < type->noutputs; i++) d->value[i] = d->next[i];
+	}
+}
+
+/****************************** State arena ******************************/
+
+#define OSC_ARENA_LINE 64 // the cache line size, every state starts on one
+#define OSC_ARENA_PAGE 65536 // bytes the arena grows by, a thousand states or so
+
+// The arena grows by pages, which are never moved while states are in them
+typedef struct _osc_arena_page {
+	struct _osc_arena_page *next;
+	char *data; // OSC_ARENA_LINE aligned
+	unsigned long size, used;
+} osc_arena_page;
+
+struct _osc_arena {
+	osc_arena_page *first, *current; // the pages, and the one being filled
+	osc_slot *slots; // the states in the arena, whose owners point at it
+	unsigned long generation; // counts the fillings
+	double time; // of the current filling
+	const void *host; // the host osc_arena_of() made it for
+	struct _osc_arena *next; // the next one osc_arena_of() made
+};
+
+// The arenas of the hosts that asked osc_arena_of() for one
+static osc_arena *arena_hosts;
+static pthread_mutex_t arena_hosts_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Free all pages but the first, or all of them
+static void arena_free_pages(osc_arena *arena, int keep_first)
+{
+	osc_arena_page *page, *next;
+
+	page = arena->first;
+	if(keep_first && page) {
+		next = page->next;
+		page->next = 0;
+		page = next;
+	}
+	else arena->first = 0;
+	for(; page; page = next){
+		next = page->next;
+		free(page);
+	}
+	arena->current = arena->first;
+}
+
+// Move every state home and start filling the arena from its first page, the
+// pages a bigger chain needed before are freed, the next filling gets new ones
+static void arena_restart(osc_arena *arena, double time)
+{
+	osc_slot *slot, *next;
+
+	for(slot = arena->slots; slot; slot = next){
+		next = slot->next;
+		memcpy(slot->home, slot->state, slot->size);
+		slot->state = slot->home;
+		slot->arena = 0;
+		slot->prev = slot->next = 0;
+	}
+	arena->slots = 0;
+	arena_free_pages(arena, 1);
+	if(arena->first) arena->first->used = 0;
+	arena->generation++;
+	arena->time = time;
+}
+
+// The next size bytes of the arena, a new page if the current one is full
+static void *arena_alloc(osc_arena *arena, unsigned long size)
+{
+	osc_arena_page *page = arena->current, **last;
+	unsigned long page_size;
+	char *memory;
+	void *block;
+
+	while(page && page->used + size > page->size) page = page->next;
+	if(!page) {
+		page_size = size > OSC_ARENA_PAGE ? size : OSC_ARENA_PAGE;
+		// the header first, then the data aligned to the next line
+		memory = (char *) malloc(sizeof(osc_arena_page) + page_size + OSC_ARENA_LINE);
+		if(!memory) return 0;
+		page = (osc_arena_page *) memory;
+		page->data = (char *) (((uintptr_t) (memory + sizeof(osc_arena_page)) + OSC_ARENA_LINE - 1) &
+			~(uintptr_t) (OSC_ARENA_LINE - 1));
+		page->size = page_size;
+		page->used = 0;
+		page->next = 0;
+		for(last = &arena->first; *last; last = &(*last)->next);
+		*last = page;
+	}
+	arena->current = page;
+	block = page->data + page->used;
+	page->used += size;
+	return block;
+}
+
+osc_arena *osc_arena_new(void)
+{
+	return (osc_arena *) calloc(1, sizeof(osc_arena));
+}
+
+void osc_arena_free(osc_arena *arena)
+{
+	if(!arena) return;
+	while(arena->slots) osc_slot_release(arena->slots);
+	arena_free_pages(arena, 0);
+	free(arena);
+}
+
+osc_arena *osc_arena_of(const void *host)
+{
+	osc_arena *arena;
+
+	// hosts build their chains on threads of their own, maybe at the same time
+	pthread_mutex_lock(&arena_hosts_lock);
+	for(arena = arena_hosts; arena && arena->host != host; arena = arena->next);
+	if(!arena && (arena = osc_arena_new())) {
+		arena->host = host;
+		arena->next = arena_hosts;
+		arena_hosts = arena;
+	}
+	pthread_mutex_unlock(&arena_hosts_lock);
+	return arena;
+}
+
+void osc_slot_init(osc_slot *slot, void *home, unsigned long size)
+{
+	slot->state = slot->home = home;
+	slot->size = size;
+	slot->arena = 0;
+	slot->generation = 0;
+	slot->prev = slot->next = 0;
+}
+
+void osc_slot_place(osc_arena *arena, osc_slot *slot, double time)
+{
+	void *block;
+
+	// without an arena the state simply stays home
+	if(!arena) return;
+	// a chain is built at one time, a placement at another starts the next one
+	if(!arena->generation || time != arena->time) arena_restart(arena, time);
+	// a chain built again at the same time leaves what's been placed where it is
+	else if(slot->arena == arena && slot->generation == arena->generation) return;
+	if(slot->arena) osc_slot_release(slot);
+
+	block = arena_alloc(arena, (slot->size + OSC_ARENA_LINE - 1) & ~(unsigned long) (OSC_ARENA_LINE - 1));
+	if(!block) return;
+	memcpy(block, slot->home, slot->size);
+	slot->state = block;
+	slot->arena = arena;
+	slot->generation = arena->generation;
+	slot->prev = 0;
+	slot->next = arena->slots;
+	if(arena->slots) arena->slots->prev = slot;
+	arena->slots = slot;
+}
+
+void osc_slot_release(osc_slot *slot)
+{
+	osc_arena *arena = slot->arena;
+
+	if(!arena) return;
+	memcpy(slot->home, slot->state, slot->size);
+	slot->state = slot->home;
+	slot->arena = 0;
+	// its block is left unused until the arena is filled again
+	if(slot->prev) slot->prev->next = slot->next;
+	else arena->slots = slot->next;
+	if(slot->next) slot->next->prev = slot->prev;
+	slot->prev = slot->next = 0;
+	// the last state gone, say with the patch that held them, takes the pages with it
+	if(!arena->slots) arena_free_pages(arena, 0);
+}
@@ -0,0 +1,799 @@
+/*****************************************************
+ * Offline batch renderer for the various           *
+ * oscillators. Renders a file of parameter sets   *
+ * through the same kernels as the Pd objects, on  *
+ * all cores, streaming each job to a WAV/raw file *
+ *****************************************************/
+
+/* Usage: osc_render [-j threads] [-sr rate] [-checksum] jobfile ("-" reads stdin)
+          osc_render -stress [-sr rate] [-bound microseconds]
+          osc_render -lfocheck [-sr rate]
+
+   Every non-empty line of the job file that doesn't start with '#' is one job,
+   made of name=value pairs separated by spaces:
+
+   osc=powSine out=pow.wav dur=10 frequency=110:880 power=2
+
+   osc         the oscillator (powSine, randOsc, varShapesOsc, allOsc, sineLoop,
+               tabOsc reading a sawtooth, or sineLoopBank, see bank_type)
+   out         output file, .wav files are written as 32-bit float WAV, anything
+               else as raw native 32-bit floats (interleaved for allOsc)
+   dur         duration in seconds
+   sr          sampling rate (defaults to -sr, or 48000)
+   phase       initial phase (0 - 1)
+   bandlimit   powSine only, 1 renders from the band-limited tables
+   seed        randOsc only, seed of the random generator (defaults to the line number)
+   overlap     1 renders with the kernels for vectors that overlap, which the
+               objects use when Pd gives an outlet the vector of an inlet, instead
+               of the restrict-qualified ones (see osc_type_select())
+
+   and one pair per input of the oscillator, named as in various_oscillators.h
+   (frequency, phase_mod, power, xfade, breakpoint, rise_power, fall_power,
+   duty_cycle, fb_amount, and ratio for sineLoopBank). A value is either a constant, or start:end for a
+   linear curve over the whole job. Inputs that aren't set are 0
+
+   -checksum prints a checksum of every job's output (the 32-bit floats as
+   they're written), one line per job in the order of the file, and makes out=
+   optional. The fixed point kernels (make OSC_FIXED=1) give the same output on
+   any machine, so the checksums of a build on one machine are the reference
+   for a build on another, e.g. osc_render -checksum jobs > x86.txt on a PC and
+   osc_render -checksum jobs | diff x86.txt - on the ARM board
+
+   -stress doesn't render any files, it feeds every oscillator adversarial
+   inputs instead (huge, negative, infinite and NaN values, denormals and the
+   edges of the clipped ranges, one input at a time, all at once and mixed at
+   random per sample), timing every 64 sample block. What's checked is the
+   first run of every block, and the first block of every case runs after the
+   caches have been filled with something else, so the cost of a cold cache
+   counts. Blocks are timed in the thread's CPU time, so the OS running
+   something else in between doesn't. A case with a block over -bound (100
+   microseconds by default) runs again, cold and from the same state, and it
+   fails if every run has one, so an interrupt can't fail it but a cold cache
+   that always costs too much does. It also fails if an oscillator doesn't give
+   finite output again once its inputs are back to normal. That's every
+   oscillator, [tabOsc~] and [sineLoopBank~] included, rendered directly, in
+   the LFO modes of the objects that have them, and through an event queue fed
+   phase resets to the same values, bandlimit and LFO changes every block.
+   Each block is also rendered a few more times from a copy of the state, and
+   the slowest of the fastest runs is printed too, the cost of the input
+   rather than of the caches or the OS
+
+   -lfocheck renders [varShapesOsc~] and [allOsc~] at full rate and decimated
+   (see osc_decimator in various_oscillators.h), every 16 samples and once per
+   block, and fails if the decimated output differs from the full rate one at
+   the points the decimator computes */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <math.h>
+#include <float.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "various_oscillators.h"
+
+// Constant definitions
+#define RENDER_BLOCKSIZE 1024
+#define RENDER_MAXINPUTS 8
+#define RENDER_MAXOUTPUTS 4
+#define RENDER_LINESIZE 4096
+#define STRESS_BLOCKSIZE 64 // Pd's block size
+#define STRESS_BLOCKS 32 // blocks per case
+#define STRESS_BOUND 100 // default bound per block in microseconds
+#define STRESS_REPEATS 8 // times each block is timed, the first is checked, the fastest printed
+#define STRESS_EVICT (8 << 20) // bytes written before a case, more than most L2 caches
+#define STRESS_RUNS 3 // times a case over the bound runs before it fails
+#define TABOSC_CYCLE 2048 // samples of the sawtooth [tabOsc~] reads
+#define LFOCHECK_SAMPLES 1024 // rendered per oscillator and factor
+#define LFOCHECK_TOLERANCE 1e-3 // the phase moved in one step rounds differently
+
+// One line of the job file
+typedef struct _job {
+	int line;
+	const osc_type *type;
+	char *out;
+	double duration, sr;
+	double start[RENDER_MAXINPUTS], end[RENDER_MAXINPUTS]; // linear curves of the inputs
+	double phase, bandlimit, seed;
+	int overlap; // render with type, not type->separate
+	unsigned long long checksum; // of the output, see -checksum
+	int failed;
+} t_job;
+
+// Work-stealing deque of job indices, the owner pops from the tail
+// and idle workers steal from the head
+typedef struct _deque {
+	pthread_mutex_t lock;
+	int *jobs;
+	int head, tail;
+} t_deque;
+
+typedef struct _worker {
+	pthread_t thread;
+	int id;
+} t_worker;
+
+static t_job *jobs;
+static int njobs;
+static int checksum;
+static t_deque *deques;
+static int nworkers;
+static const osc_wavetable *saw_table; // what [tabOsc~] jobs read
+
+// Write little-endian integers, WAV files are little-endian on any machine
+static void write_u32(FILE *f, unsigned long v)
+{
+	fputc(v & 0xff, f); fputc((v >> 8) & 0xff, f);
+	fputc((v >> 16) & 0xff, f); fputc((v >> 24) & 0xff, f);
+}
+
+static void write_u16(FILE *f, unsigned int v)
+{
+	fputc(v & 0xff, f); fputc((v >> 8) & 0xff, f);
+}
+
+// The header of a 32-bit float WAV file, the size is known before rendering
+static void write_wav_header(FILE *f, int channels, int sr, unsigned long frames)
+{
+	unsigned long data_size = frames * channels * 4;
+
+	fwrite("RIFF", 1, 4, f);
+	write_u32(f, 36 + data_size);
+	fwrite("WAVEfmt ", 1, 8, f);
+	write_u32(f, 16);
+	write_u16(f, 3); // IEEE float
+	write_u16(f, channels);
+	write_u32(f, sr);
+	write_u32(f, (unsigned long) sr * channels * 4);
+	write_u16(f, channels * 4);
+	write_u16(f, 32);
+	fwrite("data", 1, 4, f);
+	write_u32(f, data_size);
+}
+
+static int is_wav(const char *path)
+{
+	int len = strlen(path);
+	return len > 4 && !strcasecmp(path + len - 4, ".wav");
+}
+
+// 64 bit FNV-1a over the little-endian bytes of the samples, so that machines
+// of either byte order get the same checksum from the same output
+static unsigned long long checksum_add(unsigned long long hash, const float *samples, int n)
+{
+	unsigned int bits;
+	int i, byte;
+
+	for(i = 0; i < n; i++){
+		memcpy(&bits, &samples[i], sizeof(bits));
+		for(byte = 0; byte < 4; byte++, bits >>= 8)
+			hash = (hash ^ (bits & 0xff)) * 0x100000001b3ull;
+	}
+	return hash;
+}
+
+/* [sineLoopBank~] as an osc_type, so it's rendered and stressed like the others.
+   Its voices' frequencies and feedback amounts are parameters, which are set
+   every block from the first samples of two more inputs, one sample per voice.
+   The voices fill a group of SIMD lanes and part of another */
+#define BANK_VOICES (OSC_SINELOOPBANK_LANES + 3)
+static const char *const bank_inputs[] = { "ratio", "frequency", "fb_amount" };
+
+static void bank_init(void *x, osc_sample sr)
+{
+	osc_sineLoopBank_init((osc_sineLoopBank *) x, sr, BANK_VOICES);
+}
+
+static void bank_set_param(void *x, int param, osc_sample value)
+{
+	osc_sineLoopBank_set_param((osc_sineLoopBank *) x, -1, param, value);
+}
+
+static void bank_render(void *x, const osc_sample *const *inputs, osc_sample *const *outputs, int n)
+{
+	osc_sineLoopBank *bank = (osc_sineLoopBank *) x;
+	int voice;
+
+	for(voice = 0; voice < bank->nvoices; voice++){
+		osc_sineLoopBank_set_param(bank, voice, OSC_PARAM_FREQUENCY, inputs[1][voice % n]);
+		osc_sineLoopBank_set_param(bank, voice, OSC_PARAM_FEEDBACK, inputs[2][voice % n]);
+	}
+	osc_sineLoopBank_render(bank, inputs[0], 0, outputs[0], n);
+}
+
+static const osc_type bank_type = {
+	"sineLoopBank", 3, 1, bank_inputs, sizeof(osc_sineLoopBank), bank_init, bank_set_param, bank_render, 0
+};
+
+// An oscillator of osc_types[], or one of the two that aren't in it
+static const osc_type *render_type_find(const char *name)
+{
+	static const osc_type *const others[] = { &osc_tabOsc_type, &bank_type };
+	int len = strlen(name), i;
+
+	if(len && name[len - 1] == '~') len--;
+	for(i = 0; i < (int) (sizeof(others) / sizeof(others[0])); i++)
+		if((int) strlen(others[i]->name) == len && !strncmp(others[i]->name, name, len)) return others[i];
+	return osc_type_find(name);
+}
+
+// The sawtooth [tabOsc~] reads, in jobs and in -stress
+static osc_wavetable *saw_table_new(void)
+{
+	osc_sample cycle[TABOSC_CYCLE];
+	int i;
+
+	for(i = 0; i < TABOSC_CYCLE; i++) cycle[i] = 2.0 * i / TABOSC_CYCLE - 1;
+	return osc_wavetable_new(cycle, TABOSC_CYCLE);
+}
+
+// Render one job block by block, so only one block is ever held in memory
+static int render_job(t_job *job)
+{
+	const osc_type *type = job->type;
+	const osc_type *render;
+	osc_sample in_buf[RENDER_MAXINPUTS][RENDER_BLOCKSIZE];
+	osc_sample out_buf[RENDER_MAXOUTPUTS][RENDER_BLOCKSIZE];
+	const osc_sample *inputs[RENDER_MAXINPUTS];
+	osc_sample *outputs[RENDER_MAXOUTPUTS];
+	float interleaved[RENDER_BLOCKSIZE * RENDER_MAXOUTPUTS];
+	unsigned long frames = (unsigned long) (job->duration * job->sr + 0.5);
+	unsigned long done, i;
+	int n, input, output;
+	void *state;
+	FILE *f = 0;
+
+	// with -checksum a job may have no file to write
+	if(job->out && !(f = fopen(job->out, "wb"))) {
+		fprintf(stderr, "line %d: can't open %s\n", job->line, job->out);
+		return -1;
+	}
+	if(!(state = malloc(type->size))) {
+		if(f) fclose(f);
+		return -1;
+	}
+	type->init(state, job->sr);
+	if(type == &osc_tabOsc_type) ((osc_tabOsc *) state)->table = saw_table;
+	type->set_param(state, OSC_PARAM_PHASE, job->phase);
+	type->set_param(state, OSC_PARAM_BANDLIMIT, job->bandlimit);
+	type->set_param(state, OSC_PARAM_SEED, job->seed);
+	for(input = 0; input < type->ninputs; input++) inputs[input] = in_buf[input];
+	for(output = 0; output < type->noutputs; output++) outputs[output] = out_buf[output];
+	render = job->overlap ? type : osc_type_select(type, inputs, outputs, RENDER_BLOCKSIZE);
+
+	if(f && is_wav(job->out)) write_wav_header(f, type->noutputs, (int) job->sr, frames);
+	job->checksum = 0xcbf29ce484222325ull;
+
+	for(done = 0; done < frames; done += n){
+		n = frames - done < RENDER_BLOCKSIZE ? frames - done : RENDER_BLOCKSIZE;
+		// fill the input curves
+		for(input = 0; input < type->ninputs; input++){
+			double slope = (job->end[input] - job->start[input]) / frames;
+			for(i = 0; i < (unsigned long) n; i++)
+				in_buf[input][i] = job->start[input] + slope * (done + i);
+		}
+		render->render(state, inputs, outputs, n);
+		for(i = 0; i < (unsigned long) n; i++)
+			for(output = 0; output < type->noutputs; output++)
+				interleaved[i * type->noutputs + output] = out_buf[output][i];
+		if(checksum) job->checksum = checksum_add(job->checksum, interleaved, n * type->noutputs);
+		if(f && fwrite(interleaved, sizeof(float) * type->noutputs, n, f) != (size_t) n) {
+			fprintf(stderr, "line %d: error writing %s\n", job->line, job->out);
+			free(state);
+			fclose(f);
+			return -1;
+		}
+	}
+	free(state);
+	if(f && fclose(f)) {
+		fprintf(stderr, "line %d: error writing %s\n", job->line, job->out);
+		return -1;
+	}
+	return 0;
+}
+
+// Take a job from our own deque, or steal one from another worker's
+static int next_job(int id)
+{
+	int victim, job = -1;
+	t_deque *deque = &deques[id];
+
+	pthread_mutex_lock(&deque->lock);
+	if(deque->head < deque->tail) job = deque->jobs[--deque->tail];
+	pthread_mutex_unlock(&deque->lock);
+	if(job >= 0) return job;
+
+	for(victim = (id + 1) % nworkers; victim != id; victim = (victim + 1) % nworkers){
+		deque = &deques[victim];
+		pthread_mutex_lock(&deque->lock);
+		if(deque->head < deque->tail) job = deque->jobs[deque->head++];
+		pthread_mutex_unlock(&deque->lock);
+		if(job >= 0) return job;
+	}
+	// no job is ever added once rendering starts, so all deques are empty
+	return -1;
+}
+
+static void *worker_main(void *arg)
+{
+	t_worker *worker = (t_worker *) arg;
+	int job;
+
+	while((job = next_job(worker->id)) >= 0)
+		jobs[job].failed = render_job(&jobs[job]);
+	return 0;
+}
+
+// Parse "value" or "start:end" into a linear curve
+static int parse_curve(const char *s, double *start, double *end)
+{
+	char *colon;
+
+	*start = *end = strtod(s, &colon);
+	if(colon == s) return -1;
+	if(*colon == ':') {
+		const char *rest = colon + 1;
+		*end = strtod(rest, &colon);
+		if(colon == rest) return -1;
+	}
+	return *colon ? -1 : 0;
+}
+
+static int parse_job(t_job *job, char *text, int line, double sr)
+{
+	char *pair, *value, *save;
+	int input;
+
+	memset(job, 0, sizeof(t_job));
+	job->line = line;
+	job->sr = sr;
+	job->seed = line;
+	for(pair = strtok_r(text, " \t\r\n", &save); pair; pair = strtok_r(0, " \t\r\n", &save)){
+		if(!(value = strchr(pair, '='))) {
+			fprintf(stderr, "line %d: expected name=value, got '%s'\n", line, pair);
+			return -1;
+		}
+		*value++ = 0;
+		if(!strcmp(pair, "osc")) {
+			if(!(job->type = render_type_find(value))) {
+				fprintf(stderr, "line %d: no oscillator called '%s'\n", line, value);
+				return -1;
+			}
+		}
+		else if(!strcmp(pair, "out")) job->out = strdup(value);
+		else if(!strcmp(pair, "dur")) job->duration = atof(value);
+		else if(!strcmp(pair, "sr")) job->sr = atof(value);
+		else if(!strcmp(pair, "phase")) job->phase = atof(value);
+		else if(!strcmp(pair, "bandlimit")) job->bandlimit = atof(value);
+		else if(!strcmp(pair, "seed")) job->seed = atof(value);
+		else if(!strcmp(pair, "overlap")) job->overlap = atoi(value);
+		else {
+			// the inputs need the oscillator, so osc= has to come first
+			if(!job->type) {
+				fprintf(stderr, "line %d: osc= must come before '%s'\n", line, pair);
+				return -1;
+			}
+			for(input = 0; input < job->type->ninputs; input++)
+				if(!strcmp(pair, job->type->input_names[input])) break;
+			if(input == job->type->ninputs) {
+				fprintf(stderr, "line %d: %s has no input called '%s'\n", line, job->type->name, pair);
+				return -1;
+			}
+			if(parse_curve(value, &job->start[input], &job->end[input])) {
+				fprintf(stderr, "line %d: bad value '%s' for %s\n", line, value, pair);
+				return -1;
+			}
+		}
+	}
+	if(!job->type || (!job->out && !checksum) || job->duration <= 0 || job->sr <= 0) {
+		fprintf(stderr, "line %d: a job needs at least osc=, out= and dur=\n", line);
+		return -1;
+	}
+	return 0;
+}
+
+// The values fed to the oscillators in -stress mode
+static const double stress_values[] = {
+	1e9, -1e9, 1e30, -1e30, INFINITY, -INFINITY, NAN,
+	0, 1, -1, 0.9999999, 1.0000001, 1e-40, -1e-40, 1e-310
+};
+#define STRESS_NVALUES (int) (sizeof(stress_values) / sizeof(stress_values[0]))
+
+// The CPU time of this thread, which leaves out the time the OS runs something
+// else, so a single run can be checked
+static double now_us(void)
+{
+	struct timespec t;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t);
+	return t.tv_sec * 1e6 + t.tv_nsec * 1e-3;
+}
+
+// How a stress case renders the oscillator
+enum {
+	STRESS_DIRECT, // its render function, as osc_render does
+	STRESS_LFO16, // through a decimator, as the LFO modes of the objects do
+	STRESS_LFOBLOCK,
+	STRESS_QUEUE, // through an event queue fed events every block, as every object does
+	STRESS_MODES
+};
+static const char *const stress_mode_names[] = { "", "lfo 16", "lfo block", "queue" };
+
+// The oscillators with an LFO mode
+static const char *const lfo_names[] = { "varShapesOsc", "randOsc", "allOsc" };
+#define LFO_NNAMES (int) (sizeof(lfo_names) / sizeof(lfo_names[0]))
+
+// What a stress case renders, with copies to render each block again from
+typedef struct _stress {
+	const osc_type *type;
+	void *state, *state_copy;
+	void *state_case; // the state before a case, to run it again from
+	osc_decimator decimator, decimator_copy;
+	osc_queue queue, queue_copy; // the copy shares the events, rendering only reads them
+	osc_event events[OSC_QUEUE_SIZE];
+	int mode;
+	const osc_wavetable *table; // what [tabOsc~] reads
+} t_stress;
+
+/* The events pushed before every block in STRESS_QUEUE mode: phase resets to
+   value at offsets before, in and past the block, bandlimit set to value, and
+   the LFO mode changed, to a different factor every block */
+static void stress_push_events(osc_queue *q, int block, double value)
+{
+	static const int offsets[] = { -7, 0, 1, 31, 63, STRESS_BLOCKSIZE, 1 << 20 };
+	// STRESS_BLOCKS - 1 leaves it at 0, so recovering is checked at full rate
+	static const int factors[] = { 16, 0, -1, 1, 3, 1000000 };
+	osc_event event;
+	int i;
+
+	event.value[1] = 0;
+	for(i = 0; i < (int) (sizeof(offsets) / sizeof(offsets[0])); i++){
+		event.param = OSC_PARAM_PHASE;
+		event.offset = offsets[i];
+		event.value[0] = value;
+		osc_queue_push(q, &event);
+	}
+	event.param = OSC_PARAM_BANDLIMIT;
+	event.offset = STRESS_BLOCKSIZE / 2;
+	osc_queue_push(q, &event);
+	event.param = OSC_PARAM_DECIMATE;
+	event.offset = STRESS_BLOCKSIZE / 3;
+	event.value[0] = factors[block % (int) (sizeof(factors) / sizeof(factors[0]))];
+	osc_queue_push(q, &event);
+}
+
+static void stress_render(t_stress *stress, const osc_type *type, const osc_sample *const *inputs, osc_sample *const *outputs)
+{
+	if(stress->mode == STRESS_QUEUE)
+		osc_queue_render(&stress->queue, type, stress->state, &stress->decimator, inputs, outputs, STRESS_BLOCKSIZE);
+	else if(stress->mode != STRESS_DIRECT)
+		osc_decimator_render(&stress->decimator, type, stress->state, inputs, outputs, STRESS_BLOCKSIZE);
+	else type->render(stress->state, inputs, outputs, STRESS_BLOCKSIZE);
+}
+
+// Fill the caches with something else, so the next block runs cold
+static void stress_evict(void)
+{
+	static volatile char *evict;
+	int i;
+
+	if(!evict && !(evict = malloc(STRESS_EVICT))) return;
+	for(i = 0; i < STRESS_EVICT; i += 64) evict[i] = i;
+}
+
+/* Run one stress case, input set to value (all inputs if input is -1, a random
+   value per input and sample if value is NAN and input is -2), and return the
+   slowest first run of a block in microseconds, or -1 if the oscillator didn't
+   recover. The slowest block of the fastest runs goes to warm */
+static double stress_case(t_stress *stress, int input, double value, double *warm)
+{
+	osc_sample in_buf[RENDER_MAXINPUTS][STRESS_BLOCKSIZE];
+	osc_sample out_buf[RENDER_MAXOUTPUTS][STRESS_BLOCKSIZE];
+	const osc_sample *inputs[RENDER_MAXINPUTS];
+	osc_sample *outputs[RENDER_MAXOUTPUTS];
+	const osc_type *type = stress->type;
+	double start, elapsed, fastest = DBL_MAX, slowest = 0;
+	int block, repeat, i, j;
+
+	*warm = 0;
+	for(i = 0; i < type->ninputs; i++) inputs[i] = in_buf[i];
+	for(i = 0; i < type->noutputs; i++) outputs[i] = out_buf[i];
+	// the separate kernels, as an object whose vectors don't overlap renders them
+	type = osc_type_select(type, inputs, outputs, STRESS_BLOCKSIZE);
+	osc_decimator_init(&stress->decimator, stress->mode == STRESS_LFO16 ? 16 :
+		stress->mode == STRESS_LFOBLOCK ? -1 : 0);
+	osc_queue_init(&stress->queue, stress->events);
+
+	for(block = 0; block < STRESS_BLOCKS; block++){
+		for(i = 0; i < type->ninputs; i++){
+			for(j = 0; j < STRESS_BLOCKSIZE; j++){
+				if(input == -2) in_buf[i][j] = stress_values[rand() % STRESS_NVALUES];
+				else if(input == -1 || input == i) in_buf[i][j] = value;
+				else in_buf[i][j] = i ? 0.5 : 440;
+			}
+		}
+		if(stress->mode == STRESS_QUEUE)
+			stress_push_events(&stress->queue, block, input == -2 ? stress_values[rand() % STRESS_NVALUES] : value);
+		memcpy(stress->state_copy, stress->state, type->size);
+		stress->decimator_copy = stress->decimator;
+		if(stress->mode == STRESS_QUEUE) memcpy(&stress->queue_copy, &stress->queue, sizeof(osc_queue));
+		if(!block) stress_evict();
+		fastest = DBL_MAX;
+		for(repeat = 0; repeat < STRESS_REPEATS; repeat++){
+			if(repeat) {
+				memcpy(stress->state, stress->state_copy, type->size);
+				stress->decimator = stress->decimator_copy;
+				if(stress->mode == STRESS_QUEUE) memcpy(&stress->queue, &stress->queue_copy, sizeof(osc_queue));
+			}
+			start = now_us();
+			stress_render(stress, type, inputs, outputs);
+			elapsed = now_us() - start;
+			if(!repeat && elapsed > slowest) slowest = elapsed;
+			if(elapsed < fastest) fastest = elapsed;
+		}
+		if(fastest > *warm) *warm = fastest;
+	}
+
+	// back to normal inputs, the output must be finite again
+	for(i = 0; i < type->ninputs; i++)
+		for(j = 0; j < STRESS_BLOCKSIZE; j++) in_buf[i][j] = i ? 0.5 : 440;
+	for(block = 0; block < 2; block++){
+		stress_render(stress, type, inputs, outputs);
+		for(i = 0; i < type->noutputs; i++)
+			for(j = 0; j < STRESS_BLOCKSIZE; j++)
+				if(!isfinite(out_buf[i][j])) return -1;
+	}
+	return slowest;
+}
+
+// Every case of one oscillator rendered one way, returns 1 if any failed
+static int stress_oscillator(t_stress *stress, double sr, double bound)
+{
+	const osc_type *type = stress->type;
+	double slowest, warm, worst = 0, worst_warm = 0;
+	char name[64], worst_name[80] = "";
+	int bandlimit, input, value, run, failed = 0;
+
+	type->init(stress->state, sr);
+	if(type == &osc_tabOsc_type) ((osc_tabOsc *) stress->state)->table = stress->table;
+	// powSine~ once with pow(cos()) and once with its tables, the rest ignore it
+	for(bandlimit = 0; bandlimit < 2; bandlimit++){
+		type->set_param(stress->state, OSC_PARAM_BANDLIMIT, bandlimit);
+		// one input at a time, then all of them at once, then everything mixed
+		for(input = -2; input < type->ninputs; input++){
+			for(value = 0; value < (input == -2 ? 1 : STRESS_NVALUES); value++){
+				memcpy(stress->state_case, stress->state, type->size);
+				for(run = 0; run < STRESS_RUNS; run++){
+					if(run) memcpy(stress->state, stress->state_case, type->size);
+					slowest = stress_case(stress, input, input == -2 ? NAN : stress_values[value], &warm);
+					if(slowest <= bound) break;
+				}
+				if(input == -2) snprintf(name, sizeof(name), "random mix");
+				else snprintf(name, sizeof(name), "%s = %g", input == -1 ? "all inputs" :
+					type->input_names[input], stress_values[value]);
+				if(slowest < 0) {
+					fprintf(stderr, "%s~ %s(bandlimit %d): no finite output after %s\n",
+						type->name, stress_mode_names[stress->mode], bandlimit, name);
+					failed = 1;
+				}
+				else if(slowest > worst) {
+					worst = slowest;
+					snprintf(worst_name, sizeof(worst_name), "%s%s", name, bandlimit ? ", bandlimit" : "");
+				}
+				if(warm > worst_warm) worst_warm = warm;
+			}
+		}
+	}
+	printf("%-13s %-9s slowest block %6.1f us (%s), %.1f us warm%s\n", type->name,
+		stress_mode_names[stress->mode], worst, worst_name, worst_warm, worst > bound ? " FAILED" : "");
+	return failed || worst > bound;
+}
+
+static int stress_test(double sr, double bound)
+{
+	const osc_type *types[64];
+	osc_wavetable *table;
+	t_stress *stress;
+	int ntypes = 0, i, name, failed = 0;
+
+	// the bandlimit events need the tables
+	osc_tables_init();
+
+	// every oscillator, [tabOsc~] reading a sawtooth and the bank as above
+	for(i = 0; osc_types[i].name; i++) types[ntypes++] = &osc_types[i];
+	types[ntypes++] = &osc_tabOsc_type;
+	types[ntypes++] = &bank_type;
+	if(!(table = saw_table_new()) || !(stress = malloc(sizeof(t_stress)))) {
+		fprintf(stderr, "osc_render: out of memory\n");
+		return 1;
+	}
+	stress->table = table;
+
+	for(i = 0; i < ntypes; i++){
+		stress->type = types[i];
+		stress->state = malloc(types[i]->size);
+		stress->state_copy = malloc(types[i]->size);
+		stress->state_case = malloc(types[i]->size);
+		for(stress->mode = 0; stress->mode < STRESS_MODES; stress->mode++){
+			// the LFO modes for the oscillators that have one, the queue for all of them
+			// but the bank, which applies its events itself
+			if(stress->mode == STRESS_LFO16 || stress->mode == STRESS_LFOBLOCK) {
+				for(name = 0; name < LFO_NNAMES; name++) if(!strcmp(types[i]->name, lfo_names[name])) break;
+				if(name == LFO_NNAMES) continue;
+			}
+			if(stress->mode == STRESS_QUEUE && types[i] == &bank_type) continue;
+			if(stress_oscillator(stress, sr, bound)) failed = 1;
+		}
+		free(stress->state);
+		free(stress->state_copy);
+		free(stress->state_case);
+	}
+	free(stress);
+	osc_wavetable_free(table);
+	return failed;
+}
+
+static const int lfocheck_factors[] = { 16, -1 };
+
+/* Render type at full rate and through a decimator of factor, with constant
+   inputs, and return the largest difference at the points the decimator
+   computes, every factor samples, or every block for -1 */
+static double lfocheck_case(const osc_type *type, double sr, int factor)
+{
+	static osc_sample full[RENDER_MAXOUTPUTS][LFOCHECK_SAMPLES];
+	static osc_sample decimated[RENDER_MAXOUTPUTS][LFOCHECK_SAMPLES];
+	osc_sample in_buf[RENDER_MAXINPUTS][STRESS_BLOCKSIZE];
+	const osc_sample *inputs[RENDER_MAXINPUTS];
+	osc_sample *outputs[RENDER_MAXOUTPUTS];
+	osc_decimator d;
+	void *state = malloc(type->size);
+	double error, worst = 0;
+	int pass, done, i, j, step = factor < 0 ? STRESS_BLOCKSIZE : factor;
+
+	// a frequency whose points don't fall on the waveforms' corners and jumps
+	for(i = 0; i < type->ninputs; i++)
+		for(j = 0; j < STRESS_BLOCKSIZE; j++) in_buf[i][j] = i ? 0.5 : 310;
+	for(i = 0; i < type->ninputs; i++) inputs[i] = in_buf[i];
+
+	for(pass = 0; pass < 2; pass++){
+		type->init(state, sr);
+		type->set_param(state, OSC_PARAM_SEED, 1);
+		osc_decimator_init(&d, factor);
+		for(done = 0; done < LFOCHECK_SAMPLES; done += STRESS_BLOCKSIZE){
+			for(i = 0; i < type->noutputs; i++) outputs[i] = (pass ? decimated[i] : full[i]) + done;
+			if(pass) osc_decimator_render(&d, type, state, inputs, outputs, STRESS_BLOCKSIZE);
+			else type->render(state, inputs, outputs, STRESS_BLOCKSIZE);
+		}
+	}
+	free(state);
+
+	for(i = 0; i < type->noutputs; i++){
+		for(j = 0; j < LFOCHECK_SAMPLES; j += step){
+			error = fabs(decimated[i][j] - full[i][j]);
+			if(!(error <= worst)) worst = error;
+		}
+	}
+	return worst;
+}
+
+static int lfo_check(double sr)
+{
+	const osc_type *type;
+	double error;
+	int name, factor, failed = 0;
+
+	for(name = 0; name < LFO_NNAMES; name++){
+		// [randOsc~] draws a random value every sample it computes, so
+		// decimated it plays another sequence
+		if(!strcmp(lfo_names[name], "randOsc")) continue;
+		type = osc_type_find(lfo_names[name]);
+		for(factor = 0; factor < (int) (sizeof(lfocheck_factors) / sizeof(lfocheck_factors[0])); factor++){
+			error = lfocheck_case(type, sr, lfocheck_factors[factor]);
+			printf("%-13s lfo %-5s largest error at the points %g%s\n", type->name,
+				lfocheck_factors[factor] < 0 ? "block" : "16", error,
+				!(error <= LFOCHECK_TOLERANCE) ? " FAILED" : "");
+			if(!(error <= LFOCHECK_TOLERANCE)) failed = 1;
+		}
+	}
+	return failed;
+}
+
+static void usage(void)
+{
+	fprintf(stderr, "usage: osc_render [-j threads] [-sr rate] [-checksum] jobfile\n"
+		"       osc_render -stress [-sr rate] [-bound microseconds]\n"
+		"       osc_render -lfocheck [-sr rate]\n");
+	exit(2);
+}
+
+int main(int argc, char **argv)
+{
+	char text[RENDER_LINESIZE], *p;
+	double sr = 48000;
+	int i, line = 0, failed = 0, maxjobs = 0;
+	FILE *f;
+	t_worker *workers;
+
+	// -stress takes the place of the job file
+	for(i = 1; i < argc; i++) if(!strcmp(argv[i], "-stress")) break;
+	if(i < argc) {
+		double bound = STRESS_BOUND;
+		for(i = 1; i < argc; i++){
+			if(!strcmp(argv[i], "-stress")) continue;
+			else if(!strcmp(argv[i], "-sr") && i < argc - 1) sr = atof(argv[++i]);
+			else if(!strcmp(argv[i], "-bound") && i < argc - 1) bound = atof(argv[++i]);
+			else usage();
+		}
+		return stress_test(sr, bound);
+	}
+	for(i = 1; i < argc; i++) if(!strcmp(argv[i], "-lfocheck")) break;
+	if(i < argc) {
+		for(i = 1; i < argc; i++){
+			if(!strcmp(argv[i], "-lfocheck")) continue;
+			else if(!strcmp(argv[i], "-sr") && i < argc - 1) sr = atof(argv[++i]);
+			else usage();
+		}
+		return lfo_check(sr);
+	}
+
+	nworkers = sysconf(_SC_NPROCESSORS_ONLN);
+	for(i = 1; i < argc - 1; i++){
+		if(!strcmp(argv[i], "-j") && i < argc - 2) nworkers = atoi(argv[++i]);
+		else if(!strcmp(argv[i], "-sr") && i < argc - 2) sr = atof(argv[++i]);
+		else if(!strcmp(argv[i], "-checksum")) checksum = 1;
+		else usage();
+	}
+	if(i != argc - 1) usage();
+	if(nworkers < 1) nworkers = 1;
+
+	if(!strcmp(argv[i], "-")) f = stdin;
+	else if(!(f = fopen(argv[i], "r"))) {
+		fprintf(stderr, "osc_render: can't open %s\n", argv[i]);
+		return 1;
+	}
+	while(fgets(text, sizeof(text), f)){
+		line++;
+		for(p = text; *p == ' ' || *p == '\t'; p++);
+		if(*p == '#' || *p == '\n' || *p == '\r' || !*p) continue;
+		if(njobs == maxjobs) {
+			maxjobs = maxjobs ? maxjobs * 2 : 64;
+			jobs = (t_job *) realloc(jobs, sizeof(t_job) * maxjobs);
+		}
+		if(parse_job(&jobs[njobs], p, line, sr)) failed++;
+		else njobs++;
+	}
+	if(f != stdin) fclose(f);
+
+	// the shared tables are never built while rendering, so build them here
+	osc_tables_init();
+	if(!(saw_table = saw_table_new())) {
+		fprintf(stderr, "osc_render: out of memory\n");
+		return 1;
+	}
+
+	// deal the jobs out round robin, the workers balance the rest by stealing
+	if(nworkers > njobs) nworkers = njobs ? njobs : 1;
+	deques = (t_deque *) calloc(nworkers, sizeof(t_deque));
+	workers = (t_worker *) calloc(nworkers, sizeof(t_worker));
+	for(i = 0; i < nworkers; i++){
+		pthread_mutex_init(&deques[i].lock, 0);
+		deques[i].jobs = (int *) malloc(sizeof(int) * (njobs / nworkers + 1));
+	}
+	for(i = 0; i < njobs; i++){
+		t_deque *deque = &deques[i % nworkers];
+		deque->jobs[deque->tail++] = i;
+	}
+	for(i = 0; i < nworkers; i++){
+		workers[i].id = i;
+		pthread_create(&workers[i].thread, 0, worker_main, &workers[i]);
+	}
+	for(i = 0; i < nworkers; i++) pthread_join(workers[i].thread, 0);
+
+	for(i = 0; i < njobs; i++){
+		if(jobs[i].failed) failed++;
+		else if(checksum) printf("line %d: %s %016llx\n", jobs[i].line, jobs[i].type->name, jobs[i].checksum);
+	}
+	if(failed) fprintf(stderr, "osc_render: %d of %d jobs failed\n", failed, njobs + failed);
+	return failed ? 1 : 0;
+}
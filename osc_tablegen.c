@@ -0,0 +1,110 @@
+/*****************************************************
+ * Lookup table generator for the various           *
+ * oscillators library. Run at build time, it      *
+ * prints osc_tables.h, which compiles the tables  *
+ * into the library as read-only data              *
+ *****************************************************/
+
+/* Usage: osc_tablegen > osc_tables.h
+
+   The tables used to be computed when the library was loaded, into memory
+   allocated for them. Compiled in, loading the library costs nothing and they
+   sit in the read-only pages of the library, which every process using it
+   shares. The sizes are defined here, and passed on to the library with the
+   tables. Values are printed with 17 significant digits, so the compiler
+   rounds them to float or double exactly once, like a computed table would be */
+
+#include <stdio.h>
+#include <math.h>
+
+// Constant definitions
+#define SINELOOP_STEP 512 // cosine table of [sineLoop~] and [sineLoopBank~]
+#define FIXED_COS_BITS 11 // fixed point cosine table, 2048 segments
+#define FIXED_LOG_BITS 8 // fixed point log2 and exp2 tables, 256 segments
+#define FIXED_ONE (1 << 30)
+
+// Every value on a line of its own would be a long file, so 4 to a line
+#define VALUES_PER_LINE 4
+
+/* cos(2 pi i / n) for n a multiple of 4. It's folded into the first eighth
+   of the cycle and computed in long double, with sin() past the eighth, so
+   the table is exactly symmetric, and exactly 0 and +-1 at the quarters */
+static double cos_cycle(long i, long n)
+{
+	const long double pi = 3.141592653589793238462643383279502884L;
+	long double sign = 1;
+
+	i %= n;
+	// cos() is even, and cos(pi - x) is -cos(x)
+	if(i > n / 2) i = n - i;
+	if(i > n / 4) {
+		i = n / 2 - i;
+		sign = -1;
+	}
+	// and cos(pi / 2 - x) is sin(x)
+	if(2 * i > n / 4) return (double) (sign * sinl(2 * pi * (n / 4 - i) / n));
+	return (double) (sign * cosl(2 * pi * i / n));
+}
+
+// Rounds to the nearest integer, halves away from 0
+static long round_long(double value)
+{
+	return value < 0 ? -(long) floor(-value + 0.5) : (long) floor(value + 0.5);
+}
+
+static void table_start(const char *type, const char *name, const char *size)
+{
+	printf("static const %s %s[%s] __attribute__((aligned(64))) = {", type, name, size);
+}
+
+static void table_value(int i, const char *format, double value)
+{
+	printf(i % VALUES_PER_LINE ? " " : "\n\t");
+	printf(format, value);
+	putchar(',');
+}
+
+static void table_end(void)
+{
+	printf("\n};\n\n");
+}
+
+int main(void)
+{
+	int i, size;
+
+	printf("/* Lookup tables of the various oscillators library, generated by\n"
+		"   osc_tablegen.c when the library is built. Don't edit, edit that */\n\n");
+	printf("#define SINELOOP_STEP %d\n", SINELOOP_STEP);
+	printf("#define FIXED_COS_BITS %d\n", FIXED_COS_BITS);
+	printf("#define FIXED_LOG_BITS %d\n\n", FIXED_LOG_BITS);
+
+	// one cycle, with the first value again at the end for the interpolation
+	printf("// cosine table of [sineLoop~] and [sineLoopBank~]\n");
+	table_start("osc_sample", "sineLoop_tab", "SINELOOP_STEP + 1");
+	for(i = 0; i <= SINELOOP_STEP; i++) table_value(i, "%.17g", cos_cycle(i, SINELOOP_STEP));
+	table_end();
+
+	// the fixed point kernels' tables are integers, the same in any build
+	printf("#ifdef OSC_FIXED\n");
+	printf("// cos() over a cycle in Q2.30\n");
+	table_start("int32_t", "fixed_cos_tab", "(1 << FIXED_COS_BITS) + 1");
+	for(i = 0, size = 1 << FIXED_COS_BITS; i <= size; i++)
+		table_value(i, "%.0f", round_long(cos_cycle(i, size) * FIXED_ONE));
+	table_end();
+
+	printf("// log2(1 + i / 256) in Q8.24\n");
+	table_start("int32_t", "fixed_log2_tab", "(1 << FIXED_LOG_BITS) + 1");
+	for(i = 0, size = 1 << FIXED_LOG_BITS; i <= size; i++)
+		table_value(i, "%.0f", round_long(log2(1 + (double) i / size) * (1 << 24)));
+	table_end();
+
+	printf("// 2^(-i / 256) in Q2.30\n");
+	table_start("int32_t", "fixed_exp2_tab", "(1 << FIXED_LOG_BITS) + 1");
+	for(i = 0, size = 1 << FIXED_LOG_BITS; i <= size; i++)
+		table_value(i, "%.0f", round_long(exp2(-(double) i / size) * FIXED_ONE));
+	table_end();
+	printf("#endif\n");
+
+	return ferror(stdout) ? 1 : 0;
+}
@@ -0,0 +1,494 @@
+/****************************************************
+ * Polyphonic wrapper for the various oscillators,  *
+ * allocating voices to notes and rendering only    *
+ * the voices that are actually sounding            *
+ ****************************************************/
+
+// Header files required by Pure Data
+#include "m_pd.h"
+#include <string.h>
+// The oscillator kernels
+#include "various_oscillators.h"
+
+// Constant definitions
+#define POLYOSC_MAXVOICES 256
+#define POLYOSC_DEFAULT_VOICES 8
+#define POLYOSC_DEFAULT_RAMP 5 // attack and release time in ms
+#define POLYOSC_MAXINPUTS 8
+
+// Voice stealing modes, for when a note comes in and all voices are taken
+enum {
+	POLYOSC_STEAL_OLDEST, // take the voice that was started first
+	POLYOSC_STEAL_QUIETEST, // take the voice with the lowest target amplitude
+	POLYOSC_STEAL_NONE // drop the new note
+};
+
+// Commands queued by the methods for the audio thread, past the OSC_PARAM_* values
+enum {
+	POLYOSC_CMD_NOTE = 100, // pitch, velocity
+	POLYOSC_CMD_INPUT, // input index, value
+	POLYOSC_CMD_STEAL, // stealing mode
+	POLYOSC_CMD_RAMP, // ramp time in ms
+	POLYOSC_CMD_BANDLIMIT, // on/off
+	POLYOSC_CMD_FLUSH
+};
+
+// The class pointer
+static t_class *polyOsc_class;
+
+// One voice, its oscillator's state lives in x_states
+typedef struct _polyOsc_voice {
+	t_float pitch;
+	t_float frequency;
+	t_float amp; // current amplitude
+	t_float target; // amplitude the ramp is heading to
+	t_float amp_inc; // amplitude step per sample while ramping
+	int ramp_left; // samples left until the ramp reaches its target
+	int releasing; // note off received, the voice goes idle when the ramp ends
+	unsigned long serial; // note on order, for stealing the oldest voice
+	int active_index; // position in the active list, -1 when idle
+} t_polyOsc_voice;
+
+// The object structure
+typedef struct _polyOsc {
+	// The Pd object
+	t_object obj;
+	// Rest of variables
+	const osc_type *x_type; // the oscillator every voice runs
+	const osc_type *x_render; // x_type, or its kernels for vectors that don't overlap
+	int x_nvoices;
+	t_polyOsc_voice *x_voices;
+	char *x_states; // x_nvoices oscillator states of x_type->size bytes each
+	int *x_active; // dense list of the sounding voices, the only ones rendered
+	int x_nactive;
+	unsigned long x_serial;
+	int x_steal;
+	t_float x_ramp; // ramp time in ms
+	t_float x_sr; // sampling rate
+	t_float x_params[POLYOSC_MAXINPUTS]; // the inputs shared by all voices
+	t_float x_bandlimit; // the last bandlimit, for the voices started after it
+	t_sample *x_inbuf; // one vector per input, the first one is the voice's frequency
+	t_sample *x_outbuf; // one vector per output, rendered by one voice at a time
+	int x_bufsize;
+	osc_queue x_queue; // messages on their way to the audio thread
+	osc_event x_events[OSC_QUEUE_SIZE]; // the messages themselves
+} t_polyOsc;
+
+// Function prototypes
+static void *polyOsc_new(t_symbol *s, int argc, t_atom *argv);
+static void polyOsc_free(t_polyOsc *x);
+static void polyOsc_dsp(t_polyOsc *x, t_signal **sp);
+static t_int *polyOsc_perform(t_int *w);
+static void polyOsc_list(t_polyOsc *x, t_symbol *s, int argc, t_atom *argv);
+static void polyOsc_anything(t_polyOsc *x, t_symbol *s, int argc, t_atom *argv);
+static void polyOsc_steal(t_polyOsc *x, t_symbol *s);
+static void polyOsc_ramp(t_polyOsc *x, t_float f);
+static void polyOsc_bandlimit(t_polyOsc *x, t_float f);
+static void polyOsc_flush(t_polyOsc *x);
+static void polyOsc_push(t_polyOsc *x, int cmd, t_float value, t_float value2, const char *what);
+static void polyOsc_apply(t_polyOsc *x, const osc_event *event);
+
+// Get a voice's oscillator state
+static void *polyOsc_state(t_polyOsc *x, int voice)
+{
+	return x->x_states + (voice * x->x_type->size);
+}
+
+// Start a voice ramping towards a new amplitude
+static void polyOsc_start_ramp(t_polyOsc *x, t_polyOsc_voice *voice, t_float target)
+{
+	int ramp_samples = x->x_ramp * x->x_sr * 0.001f;
+
+	if(ramp_samples < 1) ramp_samples = 1;
+	voice->target = target;
+	voice->ramp_left = ramp_samples;
+	voice->amp_inc = (target - voice->amp) / ramp_samples;
+}
+
+static void polyOsc_noteon(t_polyOsc *x, t_float pitch, t_float velocity)
+{
+	t_polyOsc_voice *voice = 0;
+	int i, index = -1;
+
+	// a note that is already sounding is retriggered on its own voice
+	for(i = 0; i < x->x_nactive; i++){
+		t_polyOsc_voice *v = &x->x_voices[x->x_active[i]];
+		if(v->pitch == pitch && !v->releasing) {
+			index = x->x_active[i];
+			break;
+		}
+	}
+	// otherwise take an idle voice
+	if(index < 0) {
+		for(i = 0; i < x->x_nvoices; i++){
+			if(x->x_voices[i].active_index < 0) {
+				index = i;
+				break;
+			}
+		}
+		if(index >= 0) {
+			// a fresh voice starts from the beginning of its cycle
+			voice = &x->x_voices[index];
+			x->x_type->init(polyOsc_state(x, index), x->x_sr);
+			// init turns bandlimit off, so it's set again
+			x->x_type->set_param(polyOsc_state(x, index), OSC_PARAM_BANDLIMIT, x->x_bandlimit);
+			voice->amp = 0;
+			voice->active_index = x->x_nactive;
+			x->x_active[x->x_nactive++] = index;
+		}
+	}
+	// otherwise steal one
+	if(index < 0) {
+		if(x->x_steal == POLYOSC_STEAL_NONE) return;
+		for(i = 0; i < x->x_nactive; i++){
+			t_polyOsc_voice *v = &x->x_voices[x->x_active[i]];
+			if(index < 0) index = x->x_active[i];
+			else if(x->x_steal == POLYOSC_STEAL_OLDEST) {
+				if(v->serial < x->x_voices[index].serial) index = x->x_active[i];
+			}
+			else if(v->target < x->x_voices[index].target) index = x->x_active[i];
+		}
+	}
+	voice = &x->x_voices[index];
+	voice->pitch = pitch;
+	voice->frequency = mtof(pitch);
+	voice->releasing = 0;
+	voice->serial = ++x->x_serial;
+	polyOsc_start_ramp(x, voice, velocity / 127.0f);
+}
+
+static void polyOsc_noteoff(t_polyOsc *x, t_float pitch)
+{
+	int i;
+
+	for(i = 0; i < x->x_nactive; i++){
+		t_polyOsc_voice *voice = &x->x_voices[x->x_active[i]];
+		if(voice->pitch == pitch && !voice->releasing) {
+			voice->releasing = 1;
+			polyOsc_start_ramp(x, voice, 0);
+			return;
+		}
+	}
+}
+
+// Fill the vector of a shared input with its value
+static void polyOsc_fill_input(t_polyOsc *x, int input)
+{
+	t_sample *vec = x->x_inbuf + (input * x->x_bufsize);
+	t_float value = x->x_params[input];
+	int i;
+
+	for(i = 0; i < x->x_bufsize; i++) vec[i] = value;
+}
+
+// The Pd class definition function
+void polyOsc_tilde_setup(void)
+{
+	// Initialize the class
+	polyOsc_class = class_new(gensym("polyOsc~"), (t_newmethod)(void (*)(void))polyOsc_new, (t_method)polyOsc_free, sizeof(t_polyOsc), 0, A_GIMME, 0);
+
+	// Bind the DSP method, which is called when the DACs are turned on
+	class_addmethod(polyOsc_class, (t_method)polyOsc_dsp, gensym("dsp"), A_CANT, 0);
+
+	// Notes come in as pitch/velocity lists, like the output of [poly] or [notein]
+	class_addlist(polyOsc_class, (t_method)polyOsc_list);
+
+	// Bind the rest of the methods
+	class_addmethod(polyOsc_class, (t_method)polyOsc_steal, gensym("steal"), A_SYMBOL, 0);
+	class_addmethod(polyOsc_class, (t_method)polyOsc_ramp, gensym("ramp"), A_FLOAT, 0);
+	class_addmethod(polyOsc_class, (t_method)polyOsc_bandlimit, gensym("bandlimit"), A_FLOAT, 0);
+	class_addmethod(polyOsc_class, (t_method)polyOsc_flush, gensym("flush"), 0);
+
+	// Any other message sets the oscillators' input with that name
+	class_addanything(polyOsc_class, (t_method)polyOsc_anything);
+
+	// Build or map the oscillators' shared tables now, not on the audio thread
+	osc_tables_init();
+
+	// Print authorship to Pd window
+	post("polyOsc~: Polyphonic wrapper for the various oscillators");
+}
+
+// The new instance routine
+static void *polyOsc_new(t_symbol *s, int argc, t_atom *argv)
+{
+	t_polyOsc *x;
+	const osc_type *type;
+	t_symbol *name = atom_getsymbolarg(0, argc, argv);
+	int i;
+	(void) s;
+
+	// The first argument is the oscillator, without it there's nothing to do
+	if(!(type = osc_type_find(name->s_name))) {
+		pd_error(0, "polyOsc~: no oscillator called '%s'", name->s_name);
+		return 0;
+	}
+
+	// Instantiate a new polyOsc~ object
+	x = (t_polyOsc *) pd_new(polyOsc_class);
+	x->x_type = x->x_render = type;
+
+	// Check for creation arguments, number of voices and stealing mode
+	osc_queue_init(&x->x_queue, x->x_events);
+	x->x_nvoices = atom_getfloatarg(1, argc, argv);
+	if(x->x_nvoices < 1) x->x_nvoices = POLYOSC_DEFAULT_VOICES;
+	if(x->x_nvoices > POLYOSC_MAXVOICES) x->x_nvoices = POLYOSC_MAXVOICES;
+	x->x_steal = POLYOSC_STEAL_OLDEST;
+	if(argc >= 3) polyOsc_steal(x, atom_getsymbolarg(2, argc, argv));
+
+	// Create one signal outlet per output of the oscillator
+	for(i = 0; i < type->noutputs; i++)
+		outlet_new(&x->obj, gensym("signal"));
+
+	// Allocate the voices, all of them idle
+	x->x_voices = (t_polyOsc_voice *) getbytes(sizeof(t_polyOsc_voice) * x->x_nvoices);
+	x->x_states = (char *) getbytes(type->size * x->x_nvoices);
+	x->x_active = (int *) getbytes(sizeof(int) * x->x_nvoices);
+	x->x_nactive = 0;
+	x->x_serial = 0;
+	x->x_ramp = POLYOSC_DEFAULT_RAMP;
+	x->x_sr = sys_getsr();
+	for(i = 0; i < x->x_nvoices; i++){
+		x->x_voices[i].active_index = -1;
+		type->init(polyOsc_state(x, i), x->x_sr);
+	}
+
+	// the shared inputs start at 0, like unconnected signal inlets
+	for(i = 0; i < POLYOSC_MAXINPUTS; i++) x->x_params[i] = 0;
+	x->x_bandlimit = 0;
+	x->x_inbuf = x->x_outbuf = 0;
+	x->x_bufsize = 0;
+
+	// Return a pointer to the new object
+	return x;
+}
+
+static void polyOsc_free(t_polyOsc *x)
+{
+	freebytes(x->x_voices, sizeof(t_polyOsc_voice) * x->x_nvoices);
+	freebytes(x->x_states, x->x_type->size * x->x_nvoices);
+	freebytes(x->x_active, sizeof(int) * x->x_nvoices);
+	if(x->x_inbuf) freebytes(x->x_inbuf, sizeof(t_sample) * x->x_bufsize * x->x_type->ninputs);
+	if(x->x_outbuf) freebytes(x->x_outbuf, sizeof(t_sample) * x->x_bufsize * x->x_type->noutputs);
+}
+
+// The perform routine
+static t_int *polyOsc_perform(t_int *w)
+{
+	// Copy the object pointer and the signal vector size
+	t_polyOsc *x = (t_polyOsc *) (w[1]);
+	int n = (int) (w[2]);
+	// the outlets' vectors follow
+	const osc_type *type = x->x_type;
+	const t_sample *inputs[POLYOSC_MAXINPUTS];
+	t_sample *scratch[POLYOSC_MAXINPUTS];
+	t_sample *frequency = x->x_inbuf;
+	t_sample *out;
+	t_float amp, amp_inc;
+	osc_event *event;
+	int i, j, output, ramp_left;
+
+	// Apply the messages received since the last block
+	while((event = osc_queue_front(&x->x_queue))) {
+		polyOsc_apply(x, event);
+		osc_queue_pop(&x->x_queue);
+	}
+
+	for(i = 0; i < type->ninputs; i++) inputs[i] = x->x_inbuf + (i * n);
+	for(i = 0; i < type->noutputs; i++) scratch[i] = x->x_outbuf + (i * n);
+
+	// Clear the outlets, the voices are added on top
+	for(output = 0; output < type->noutputs; output++){
+		out = (t_sample *) (w[3 + output]);
+		for(j = 0; j < n; j++) out[j] = 0;
+	}
+
+	// Render only the active voices, idle ones cost nothing
+	for(i = 0; i < x->x_nactive; ){
+		int index = x->x_active[i];
+		t_polyOsc_voice *voice = &x->x_voices[index];
+
+		for(j = 0; j < n; j++) frequency[j] = voice->frequency;
+		x->x_render->render(polyOsc_state(x, index), inputs, scratch, n);
+
+		// Add the voice to the outlets, following its amplitude ramp
+		amp = voice->amp;
+		amp_inc = voice->amp_inc;
+		ramp_left = voice->ramp_left;
+		for(output = 0; output < type->noutputs; output++){
+			out = (t_sample *) (w[3 + output]);
+			// every outlet follows the same ramp
+			amp = voice->amp;
+			ramp_left = voice->ramp_left;
+			for(j = 0; j < n; j++){
+				if(ramp_left) {
+					amp += amp_inc;
+					if(!--ramp_left) amp = voice->target;
+				}
+				out[j] += scratch[output][j] * amp;
+			}
+		}
+		voice->amp = amp;
+		voice->ramp_left = ramp_left;
+
+		// A released voice that has faded out leaves the active list
+		if(voice->releasing && !ramp_left) {
+			int last = x->x_active[--x->x_nactive];
+			x->x_active[i] = last;
+			x->x_voices[last].active_index = i;
+			voice->active_index = -1;
+		}
+		else i++;
+	}
+
+	// Return the next address in the DSP chain
+	return w + 3 + type->noutputs;
+}
+
+// The DSP method
+static void polyOsc_dsp(t_polyOsc *x, t_signal **sp)
+{
+	const osc_type *type = x->x_type;
+	const t_sample *inputs[POLYOSC_MAXINPUTS];
+	t_sample *scratch[POLYOSC_MAXINPUTS];
+	int i, n = sp[0]->s_n;
+	t_int *vec;
+
+	// Check if samplerate has changed
+	if(x->x_sr != sp[0]->s_sr){
+		if(! sp[0]->s_sr){
+			error("zero sampling rate!");
+			return;
+		}
+		x->x_sr = sp[0]->s_sr;
+		for(i = 0; i < x->x_nvoices; i++)
+			type->set_param(polyOsc_state(x, i), OSC_PARAM_SAMPLERATE, x->x_sr);
+	}
+
+	// Resize the voices' input and output vectors to the block size
+	if(n != x->x_bufsize) {
+		x->x_inbuf = (t_sample *) resizebytes(x->x_inbuf, sizeof(t_sample) * x->x_bufsize * type->ninputs,
+			sizeof(t_sample) * n * type->ninputs);
+		x->x_outbuf = (t_sample *) resizebytes(x->x_outbuf, sizeof(t_sample) * x->x_bufsize * type->noutputs,
+			sizeof(t_sample) * n * type->noutputs);
+		x->x_bufsize = n;
+	}
+	for(i = 1; i < type->ninputs; i++) polyOsc_fill_input(x, i);
+
+	// The voices render into the object's own vectors, which never overlap
+	for(i = 0; i < type->ninputs; i++) inputs[i] = x->x_inbuf + (i * n);
+	for(i = 0; i < type->noutputs; i++) scratch[i] = x->x_outbuf + (i * n);
+	x->x_render = osc_type_select(type, inputs, scratch, n);
+
+	/* Attach the object to the DSP chain, passing the DSP routine polyOsc_perform(),
+	the signal vector size and the outlet pointers */
+	vec = (t_int *) getbytes(sizeof(t_int) * (2 + type->noutputs));
+	vec[0] = (t_int) x;
+	vec[1] = (t_int) n;
+	for(i = 0; i < type->noutputs; i++) vec[2 + i] = (t_int) sp[i]->s_vec;
+	dsp_addv(polyOsc_perform, 2 + type->noutputs, vec);
+	freebytes(vec, sizeof(t_int) * (2 + type->noutputs));
+}
+
+/* The methods below only queue their messages, which are applied by the perform
+   routine at the start of the next block, so they can be called from any one
+   thread other than the audio one without tearing the voices */
+static void polyOsc_push(t_polyOsc *x, int cmd, t_float value, t_float value2, const char *what)
+{
+	osc_event event;
+
+	event.param = cmd;
+	event.offset = 0;
+	event.value[0] = value;
+	event.value[1] = value2;
+	if(!osc_queue_push(&x->x_queue, &event))
+		pd_error(x, "polyOsc~: too many messages in one block, %s dropped", what);
+}
+
+// Apply a queued message, on the audio thread
+static void polyOsc_apply(t_polyOsc *x, const osc_event *event)
+{
+	int i;
+
+	switch(event->param){
+		case POLYOSC_CMD_NOTE:
+			if(event->value[1] > 0) polyOsc_noteon(x, event->value[0], event->value[1]);
+			else polyOsc_noteoff(x, event->value[0]);
+			break;
+		case POLYOSC_CMD_INPUT:
+			i = event->value[0];
+			x->x_params[i] = event->value[1];
+			if(x->x_bufsize) polyOsc_fill_input(x, i);
+			break;
+		case POLYOSC_CMD_STEAL:
+			x->x_steal = event->value[0];
+			break;
+		case POLYOSC_CMD_RAMP:
+			x->x_ramp = event->value[0];
+			break;
+		case POLYOSC_CMD_BANDLIMIT:
+			x->x_bandlimit = event->value[0];
+			for(i = 0; i < x->x_nvoices; i++)
+				x->x_type->set_param(polyOsc_state(x, i), OSC_PARAM_BANDLIMIT, event->value[0]);
+			break;
+		case POLYOSC_CMD_FLUSH:
+			for(i = 0; i < x->x_nactive; i++){
+				t_polyOsc_voice *voice = &x->x_voices[x->x_active[i]];
+				if(!voice->releasing) {
+					voice->releasing = 1;
+					polyOsc_start_ramp(x, voice, 0);
+				}
+			}
+			break;
+	}
+}
+
+// Method for pitch/velocity lists, a velocity of 0 is a note off
+static void polyOsc_list(t_polyOsc *x, t_symbol *s, int argc, t_atom *argv)
+{
+	(void) s;
+	polyOsc_push(x, POLYOSC_CMD_NOTE, atom_getfloatarg(0, argc, argv), atom_getfloatarg(1, argc, argv), "note");
+}
+
+// Method to set one of the inputs shared by all voices, by its name
+static void polyOsc_anything(t_polyOsc *x, t_symbol *s, int argc, t_atom *argv)
+{
+	const osc_type *type = x->x_type;
+	int i;
+
+	// the first input is the frequency, which comes from the notes
+	for(i = 1; i < type->ninputs; i++){
+		if(!strcmp(s->s_name, type->input_names[i])) {
+			polyOsc_push(x, POLYOSC_CMD_INPUT, i, atom_getfloatarg(0, argc, argv), s->s_name);
+			return;
+		}
+	}
+	pd_error(x, "polyOsc~: %s~ has no input called '%s'", type->name, s->s_name);
+}
+
+// Method to set the voice stealing mode
+static void polyOsc_steal(t_polyOsc *x, t_symbol *s)
+{
+	if(s == gensym("oldest")) polyOsc_push(x, POLYOSC_CMD_STEAL, POLYOSC_STEAL_OLDEST, 0, "steal");
+	else if(s == gensym("quietest")) polyOsc_push(x, POLYOSC_CMD_STEAL, POLYOSC_STEAL_QUIETEST, 0, "steal");
+	else if(s == gensym("none")) polyOsc_push(x, POLYOSC_CMD_STEAL, POLYOSC_STEAL_NONE, 0, "steal");
+	else pd_error(x, "polyOsc~: unknown stealing mode '%s', use oldest, quietest or none", s->s_name);
+}
+
+// Method to set the attack and release time in ms
+static void polyOsc_ramp(t_polyOsc *x, t_float f)
+{
+	polyOsc_push(x, POLYOSC_CMD_RAMP, f < 0 ? 0 : f, 0, "ramp");
+}
+
+// Method to switch band-limited tables on and off, for [powSine~] voices
+static void polyOsc_bandlimit(t_polyOsc *x, t_float f)
+{
+	polyOsc_push(x, POLYOSC_CMD_BANDLIMIT, f, 0, "bandlimit");
+}
+
+// Method to release all sounding voices
+static void polyOsc_flush(t_polyOsc *x)
+{
+	polyOsc_push(x, POLYOSC_CMD_FLUSH, 0, 0, "flush");
+}
@@ -5,14 +5,23 @@
 
 // Header files required by Pure Data
 #include "m_pd.h"
-#include "math.h"
-
-// Constant definitions
-#define POWSINE_STEPSIZE 8192
+// The oscillator kernels
+#include "various_oscillators.h"
 
 // The class pointer
 static t_class *powSine_class;
 
+// The oscillator, rendered through each object's event queue
+static const osc_type *powSine_type;
+
+// Everything powSine_perform() reads every block, in one piece so that it
+// takes a line or two of the arena, see powSine_dsp()
+typedef struct _powSine_render {
+	const osc_type *type; // powSine_type, or its kernels for vectors that don't overlap
+	osc_queue queue; // parameter changes on their way to the audio thread
+	osc_powSine state; // the oscillator
+} t_powSine_render;
+
 // The object structure
 typedef struct _powSine {
 	// The Pd object
@@ -20,27 +29,27 @@ typedef struct _powSine {
 	// Convert floats to signals
         t_float x_f;
 	// Rest of variables
-	float x_frequency;
-	// float x_power; // use this variable only after the argument problem is solved
-        float x_phase;
-	int x_sign; // variable to control the direction of each cycle
-        float x_si; // sample increment
-        float x_sifactor; // factor for generating sampling increment
-        float x_twopi;
-        float x_sr; // sampling rate
+	osc_slot x_slot; // where x_render is now, perform is handed that address
+	t_float x_frequency;
+	// t_float x_power; // use this variable only after the argument problem is solved
+	t_powSine_render x_render; // what perform reads, while it's not in the arena, see x_slot
+	osc_event x_events[OSC_QUEUE_SIZE]; // the queue's events, only read when there are some
 } t_powSine;
 
 // Function prototypes
 void *powSine_new(void);
+void powSine_free(t_powSine *x);
 void powSine_dsp(t_powSine *x, t_signal **sp);
 void powSine_ft1(t_powSine *x, t_float f);
+void powSine_phase(t_powSine *x, t_float f, t_float offset);
+void powSine_bandlimit(t_powSine *x, t_float f);
 t_int *powSine_perform(t_int *w);
 
 // The Pd class definition function
 void powSine_tilde_setup(void)
 {
 	// Initialize the class
-	powSine_class = class_new(gensym("powSine~"), (t_newmethod)powSine_new, 0, sizeof(t_powSine), 0, A_GIMME, 0);
+	powSine_class = class_new(gensym("powSine~"), (t_newmethod)powSine_new, (t_method)powSine_free, sizeof(t_powSine), 0, A_GIMME, 0);
 
 	// Specify signal input, with automatic float to signal conversion
 	CLASS_MAINSIGNALIN(powSine_class, t_powSine, x_f);
@@ -51,6 +60,18 @@ void powSine_tilde_setup(void)
 	// Bind the method to receive a float in the last inlet (control) to reset the phase
         class_addmethod(powSine_class, (t_method)powSine_ft1, gensym("ft1"), A_FLOAT, 0);
 
+	// Bind the method to reset the phase at a sample offset of the next block
+	class_addmethod(powSine_class, (t_method)powSine_phase, gensym("phase"), A_FLOAT, A_DEFFLOAT, 0);
+
+	// Bind the method to switch band-limited table look-up on and off
+	class_addmethod(powSine_class, (t_method)powSine_bandlimit, gensym("bandlimit"), A_FLOAT, 0);
+
+	// Look the oscillator up in the kernels' table
+	powSine_type = osc_type_find("powSine");
+
+	// Build or map the band-limited tables now, not when the first bandlimit message arrives
+	osc_tables_init();
+
 	// Print authorship to Pd window
 	post("powSine~: Sinewave oscillator raised to a power\n external by Alexandros Drymonitis");
 }
@@ -80,80 +101,42 @@ void *powSine_new(void)
 	if(argc >= 2) { x->x_power = atom_getfloatarg(1, argc, argv); }
 	*/
 
-	// Initialize phase and frequency to 0 and sign variable to 1
-	x->x_phase = 0;
+	// Initialize frequency to 0
 	x->x_frequency = 0;
-	x->x_sign = 1;
-
-	// define twoPi
-	x->x_twopi = 8.0 * atan(1.0);
 
-	// get system's sampling rate and set sampling interval and factor
-	x->x_sr = sys_getsr();
-	x->x_sifactor = (float) POWSINE_STEPSIZE / x->x_sr;
-	x->x_si = x->x_frequency * x->x_sifactor;
+	// Initialize the oscillator with the system's sampling rate
+	osc_powSine_init(&x->x_render.state, sys_getsr());
+	osc_queue_init(&x->x_render.queue, x->x_events);
+	x->x_render.type = powSine_type;
+	osc_slot_init(&x->x_slot, &x->x_render, sizeof(x->x_render));
 
 	// Return a pointer to the new object
 	return x;
 }
 
+// The free method, taking the state out of the arena
+void powSine_free(t_powSine *x)
+{
+	osc_slot_release(&x->x_slot);
+}
+
 // The perform routine
 t_int *powSine_perform(t_int *w)
 {
 	// The first six variables are assigned values passed from the dsp method
 
-	// Copy the object pointer
-	t_powSine *x = (t_powSine *) (w[1]);
+	// Copy the pointer to what's rendered, in the arena or in the object
+	t_powSine_render *render = (t_powSine_render *) (w[1]);
 
-	// Copy signal vector pointers
-	t_float *frequency = (t_float *) (w[2]);
-	t_float *phase_mod = (t_float *) (w[3]);
-	t_float *power = (t_float *) (w[4]);
-	t_float *out = (t_float *) (w[5]);
+	// Copy signal vector pointers, frequency, phase modulation and power
+	t_sample *inputs[OSC_POWSINE_INPUTS] = { (t_sample *) (w[2]), (t_sample *) (w[3]), (t_sample *) (w[4]) };
+	t_sample *outputs[OSC_POWSINE_OUTPUTS] = { (t_sample *) (w[5]) };
 
 	// Copy the signal vector size
 	t_int n = w[6];
 
-	// Dereference components from the object structure
-	float si_factor = x->x_sifactor;
-	float si = x->x_si;
-	float phase = x->x_phase;
-	float twopi = x->x_twopi;
-	float sign = x->x_sign;
-	// Local variables
-	float phase_add, phase_double;
-	int phase_trunc, trunc_double;
-	float phase_wrap, wrap_double;
-	float step = (float) POWSINE_STEPSIZE;
-
-	// Perform the DSP loop
-	while(n--){
-		si = *frequency++ * si_factor;
-		// This is kind of copied from [wrap~]'s code
-		phase_add = ((phase / step) + *phase_mod++);
-		phase_trunc = phase_add;
-		if(phase_add > 0) phase_wrap = phase_add - phase_trunc;
-		else phase_wrap = phase_add - (phase_trunc - 1);
-		// [wrap]'s code was up to line above
-		// it's copied once more for wrapping the doubled frequency sent to cos
-		if(phase_wrap > 0.5) sign = 1;
-		else sign = -1;
-		phase_double = phase_wrap * 2;
-		trunc_double = phase_double;
-		if(phase_double > 0) wrap_double = phase_double - trunc_double;
-		else wrap_double = phase_double - (trunc_double - 1);
-		*out++ = pow(((cos(twopi * wrap_double) * -0.5) + 0.5), *power++) * sign;
-		phase += si;
-		while(phase > step) {
-			phase -= step;
-		}
-		while(phase < 0) {
-			phase += step;
-		}
-	}
-	// Update object's phase and sign variables
-	x->x_phase = phase;
-	x->x_sign = sign;
+	// Render the block, applying the queued parameter changes, see libvarious_oscillators.c
+	osc_queue_render(&render->queue, render->type, &render->state, 0, (const t_sample *const *) inputs, outputs, n);
 
 	// Return the next address in the DSP chain
 	return w + 7;
@@ -162,29 +145,65 @@ t_int *powSine_perform(t_int *w)
 // The DSP method
 void powSine_dsp(t_powSine *x, t_signal **sp)
 {
-	// Set table length local variable
-	float step = (float) POWSINE_STEPSIZE;
+	t_powSine_render *render;
+	osc_powSine *state;
+	t_sample *inputs[OSC_POWSINE_INPUTS] = { sp[0]->s_vec, sp[1]->s_vec, sp[2]->s_vec };
+	t_sample *outputs[OSC_POWSINE_OUTPUTS] = { sp[3]->s_vec };
+
+	// Move what perform reads next to the one placed before it in the chain, in this
+	// Pd instance's arena, and hand perform the address it ends up at
+	osc_slot_place(osc_arena_of(pd_this), &x->x_slot, clock_getlogicaltime());
+	render = x->x_slot.state;
+	state = &render->state;
 
 	// Check if samplerate has changed
-	if(x->x_sr != sp[0]->s_sr){
+	if(state->sr != sp[0]->s_sr){
                 if(! sp[0]->s_sr){
                         error("zero sampling rate!");
                         return;
                 }
-                x->x_si *= x->x_sr / sp[0]->s_sr;
-                x->x_sr = sp[0]->s_sr;
-                x->x_sifactor = step / x->x_sr;
+                osc_powSine_set_param(state, OSC_PARAM_SAMPLERATE, sp[0]->s_sr);
 	}
 
+	// Render with the restrict-qualified kernels, unless Pd gave an outlet the vector of an inlet
+	render->type = osc_type_select(powSine_type, (const t_sample *const *) inputs, outputs, sp[0]->s_n);
+
 	/* Attach the object to the DSP chain, passing the DSP routine powSine_perform(),
 	inlet and outlet pointers, and the signal vector size */
-	dsp_add(powSine_perform, 6, x, sp[0]->s_vec, sp[1]->s_vec, sp[2]->s_vec, sp[3]->s_vec, sp[0]->s_n);
+	dsp_add(powSine_perform, 6, render, sp[0]->s_vec, sp[1]->s_vec, sp[2]->s_vec, sp[3]->s_vec, sp[0]->s_n);
 }
 
 // Method to reset oscillator's phase with float input in last inlet (control)
 void powSine_ft1(t_powSine *x, t_float f)
 {
-        float scale_input = (float) POWSINE_STEPSIZE;
-        f *= scale_input;
-        x->x_phase = f;
+	powSine_phase(x, f, 0);
+}
+
+// Method to reset oscillator's phase at a sample offset of the next block, the
+// reset is queued so it can be called from any one thread other than the audio one
+void powSine_phase(t_powSine *x, t_float f, t_float offset)
+{
+	t_powSine_render *render = x->x_slot.state;
+	osc_event event;
+
+	event.param = OSC_PARAM_PHASE;
+	event.offset = offset;
+	event.value[0] = f;
+	event.value[1] = 0;
+	if(!osc_queue_push(&render->queue, &event))
+		pd_error(x, "powSine~: too many messages in one block, phase reset dropped");
+}
+
+// Method to switch band-limited table look-up on (non-zero) or off (zero)
+void powSine_bandlimit(t_powSine *x, t_float f)
+{
+	t_powSine_render *render = x->x_slot.state;
+	osc_event event;
+
+	event.param = OSC_PARAM_BANDLIMIT;
+	event.offset = 0;
+	event.value[0] = f;
+	event.value[1] = 0;
+	if(!osc_queue_push(&render->queue, &event))
+		pd_error(x, "powSine~: too many messages in one block, bandlimit dropped");
 }
@@ -5,14 +5,24 @@
 
 // Header files required by Pure Data
 #include "m_pd.h"
-#include "math.h"
-
-// Constant definitions
-#define RANDOSC_STEPSIZE 8192
+// The oscillator kernels
+#include "various_oscillators.h"
 
 // The class pointer
 static t_class *randOsc_class;
 
+// The oscillator, rendered through each object's event queue
+static const osc_type *randOsc_type;
+
+// Everything randOsc_perform() reads every block, in one piece so that it
+// takes a line or two of the arena, see randOsc_dsp()
+typedef struct _randOsc_render {
+	const osc_type *type; // randOsc_type, or its kernels for vectors that don't overlap
+	osc_queue queue; // parameter changes on their way to the audio thread
+	osc_randOsc state; // the oscillator
+	osc_decimator decimator; // LFO mode, see randOsc_lfo()
+} t_randOsc_render;
+
 // The object structure
 typedef struct _randOsc {
 	// The Pd object
@@ -20,28 +30,28 @@ typedef struct _randOsc {
 	// Convert floats to signals
         t_float x_f;
 	// Rest of variables
-	float x_frequency;
-	float x_xfade;
-	float x_power;
-        float x_phase;
-	float x_random_sample, x_old_random_sample;
-        float x_si; // sample increment
-        float x_sifactor; // factor for generating sampling increment
-        float x_twopi;
-        float x_sr; // sampling rate
+	osc_slot x_slot; // where x_render is now, perform is handed that address
+	t_float x_frequency;
+	t_float x_xfade;
+	t_float x_power;
+	t_randOsc_render x_render; // what perform reads, while it's not in the arena, see x_slot
+	osc_event x_events[OSC_QUEUE_SIZE]; // the queue's events, only read when there are some
 } t_randOsc;
 
 // Function prototypes
-void *randOsc_new(void);
+void *randOsc_new(t_symbol *s, int argc, t_atom *argv);
+void randOsc_free(t_randOsc *x);
 void randOsc_dsp(t_randOsc *x, t_signal **sp);
 void randOsc_ft1(t_randOsc *x, t_float f);
+void randOsc_phase(t_randOsc *x, t_float f, t_float offset);
+void randOsc_lfo(t_randOsc *x, t_symbol *s, int argc, t_atom *argv);
 t_int *randOsc_perform(t_int *w);
 
 // The Pd class definition function
 void randOsc_tilde_setup(void)
 {
 	// Initialize the class
-	randOsc_class = class_new(gensym("randOsc~"), (t_newmethod)randOsc_new, 0, sizeof(t_randOsc), 0, A_GIMME, 0);
+	randOsc_class = class_new(gensym("randOsc~"), (t_newmethod)(void (*)(void))randOsc_new, (t_method)randOsc_free, sizeof(t_randOsc), 0, A_GIMME, 0);
 
 	// Specify signal input, with automatic float to signal conversion
 	CLASS_MAINSIGNALIN(randOsc_class, t_randOsc, x_f);
@@ -52,12 +62,21 @@ void randOsc_tilde_setup(void)
 	// Bind the method to receive a float in the last inlet (control) to reset the phase
         class_addmethod(randOsc_class, (t_method)randOsc_ft1, gensym("ft1"), A_FLOAT, 0);
 
+	// Bind the method to reset the phase at a sample offset of the next block
+	class_addmethod(randOsc_class, (t_method)randOsc_phase, gensym("phase"), A_FLOAT, A_DEFFLOAT, 0);
+
+	// Bind the method to switch the LFO mode on and off
+	class_addmethod(randOsc_class, (t_method)randOsc_lfo, gensym("lfo"), A_GIMME, 0);
+
+	// Look the oscillator up in the kernels' table
+	randOsc_type = osc_type_find("randOsc");
+
 	// Print authorship to Pd window
 	post("randOsc~: Random oscillator (not white noise)\n external by Alexandros Drymonitis");
 }
 
 // The new instance routine
-void *randOsc_new(void)
+void *randOsc_new(t_symbol *s, int argc, t_atom *argv)
 {
 	// Basic object setup
 
@@ -82,145 +101,47 @@ void *randOsc_new(void)
 	if(argc >= 3) { x->x_power = atom_getfloatarg(2, argc, argv); }
 	*/
 
-	// Initialize phase, frequency and random samples to 0
-	x->x_phase = 0;
+	// Initialize frequency to 0
 	x->x_frequency = 0;
-	x->x_random_sample = 0;
-	x->x_old_random_sample = 0;
 
-	// define twoPi
-	x->x_twopi = 8.0 * atan(1.0);
+	// Initialize the oscillator with the system's sampling rate
+	osc_randOsc_init(&x->x_render.state, sys_getsr());
+	osc_queue_init(&x->x_render.queue, x->x_events);
+	x->x_render.type = randOsc_type;
+	osc_slot_init(&x->x_slot, &x->x_render, sizeof(x->x_render));
 
-	// get system's sampling rate and set sampling interval and factor
-	x->x_sr = sys_getsr();
-	x->x_sifactor = (float) RANDOSC_STEPSIZE / x->x_sr;
-	x->x_si = x->x_frequency * x->x_sifactor;
+	// The only creation argument is the LFO mode, -lfo <samples> or -lfo block
+	osc_decimator_init(&x->x_render.decimator, 0);
+	if(argc >= 2 && atom_getsymbolarg(0, argc, argv) == gensym("-lfo"))
+		randOsc_lfo(x, s, argc - 1, argv + 1);
 
 	// Return a pointer to the new object
 	return x;
 }
 
+// The free method, taking the state out of the arena
+void randOsc_free(t_randOsc *x)
+{
+	osc_slot_release(&x->x_slot);
+}
+
 // The perform routine
 t_int *randOsc_perform(t_int *w)
 {
 	// The first six variables are assigned values passed from the dsp method
 
-	// Copy the object pointer
-	t_randOsc *x = (t_randOsc *) (w[1]);
+	// Copy the pointer to what's rendered, in the arena or in the object
+	t_randOsc_render *render = (t_randOsc_render *) (w[1]);
 
-	// Copy signal vector pointers
-	t_float *frequency = (t_float *) (w[2]);
-	t_float *xfade = (t_float *) (w[3]);
-	t_float *power = (t_float *) (w[4]);
-	t_float *out = (t_float *) (w[5]);
+	// Copy signal vector pointers, frequency, xfade and power
+	t_sample *inputs[OSC_RANDOSC_INPUTS] = { (t_sample *) (w[2]), (t_sample *) (w[3]), (t_sample *) (w[4]) };
+	t_sample *outputs[OSC_RANDOSC_OUTPUTS] = { (t_sample *) (w[5]) };
 
 	// Copy the signal vector size
 	t_int n = w[6];
 
-	// Dereference components from the object structure
-	float si_factor = x->x_sifactor;
-	float si = x->x_si;
-	float phase = x->x_phase;
-	float twopi = x->x_twopi;
-	float random_sample = x->x_random_sample;
-	float old_random_sample = x->x_old_random_sample;
-	// Local variables
-        float step = (float) RANDOSC_STEPSIZE;
-	float xfade_local, invert_xfade;
-	float cos_phase, tri_phase;
-	float cos_tri_add;
-	float noise;
-	int randval;
-	// Variables for scale and offset
-	float scale, offset;
-	float random_bipolar, old_random_bipolar;
-	float abs_random_bipolar, abs_old_random_bipolar;
-	float max_sample, max_absolute_sample;
-	float sample_diff;
-
-
-	// Perform the DSP loop
-	while(n--){
-		// Create a random sample at each loop iteration (copied from [noise~]'s code
-		noise = ((float)((randval & 0x7fffffff) - 0x40000000)) *
-           	 (float)(1.0 / 0x40000000);
-        	randval = randval * 435898247 + 382842987;
-		noise = noise * 0.5 + 0.5;
-		// Set xfade vector to a local variable
-		xfade_local = *xfade++;
-		invert_xfade = 1 - xfade_local;
-		// Set scale and offset values according to random samples
-		sample_diff = random_sample - old_random_sample;
-		if(sample_diff < 0) {
-			scale = sample_diff * -1;
-		}
-		else {
-			scale = sample_diff;
-		}
-		random_bipolar = (random_sample * 2) - 1;
-		old_random_bipolar = (old_random_sample * 2) - 1;
-		// Get absolute values of bipolar random values
-		if(random_bipolar < 0) {
-			abs_random_bipolar = random_bipolar * -1;
-		}
-		else {
-			abs_random_bipolar = random_bipolar;
-		}
-		if(old_random_bipolar < 0) {
-			abs_old_random_bipolar = old_random_bipolar * -1;
-		}
-		else {
-			abs_old_random_bipolar = old_random_bipolar;
-		}
-		// Get maximum absolute sample
-		if(abs_random_bipolar > abs_old_random_bipolar) {
-			max_absolute_sample = abs_random_bipolar;
-		}
-		else {
-			max_absolute_sample = abs_old_random_bipolar;
-		}
-		offset = max_absolute_sample - scale;
-		// Get maximum sample
-		if(random_bipolar > old_random_bipolar) {
-			max_sample = random_bipolar;
-		}
-		else {
-			max_sample = old_random_bipolar;
-		}
-		if(max_sample > scale) {
-			offset *= 1;
-		}
-		else {
-			offset *= -1;
-		}
-		// Phase increment
-		si = *frequency++ * si_factor;
-		// Cosine and triangle values
-		if(random_sample > old_random_sample) {
-			cos_phase = ((phase / step) * 0.5) + 0.5;
-			tri_phase = phase / step;
-		}
-		else {
-			cos_phase = (phase / step) * 0.5;
-			tri_phase = ((phase / step) * -1) + 1;
-		}
-		cos_tri_add = (((cos(twopi * cos_phase) * 0.5) + 0.5) * invert_xfade) + (tri_phase * xfade_local);
-		*out++ = (((pow(cos_tri_add, *power++) * 2) - 1) * scale) + offset;
-		phase += si;
-		while(phase > step) {
-			phase -= step;
-			old_random_sample = random_sample;
-        		random_sample = noise;
-		}
-		while(phase < 0) {
-			phase += step;
-		}
-	}
-
-	// Update object's phase variable
-	x->x_phase = phase;
-	x->x_random_sample = random_sample;
-	x->x_old_random_sample = old_random_sample;
+	// Render the block, applying the queued parameter changes, see libvarious_oscillators.c
+	osc_queue_render(&render->queue, render->type, &render->state, &render->decimator, (const t_sample *const *) inputs, outputs, n);
 
 	// Return the next address in the DSP chain
 	return w + 7;
@@ -229,29 +150,70 @@ t_int *randOsc_perform(t_int *w)
 // The DSP method
 void randOsc_dsp(t_randOsc *x, t_signal **sp)
 {
-	// Set table length local variable
-	float step = (float) RANDOSC_STEPSIZE;
+	t_randOsc_render *render;
+	osc_randOsc *state;
+	t_sample *inputs[OSC_RANDOSC_INPUTS] = { sp[0]->s_vec, sp[1]->s_vec, sp[2]->s_vec };
+	t_sample *outputs[OSC_RANDOSC_OUTPUTS] = { sp[3]->s_vec };
+
+	// Move what perform reads next to the one placed before it in the chain, in this
+	// Pd instance's arena, and hand perform the address it ends up at
+	osc_slot_place(osc_arena_of(pd_this), &x->x_slot, clock_getlogicaltime());
+	render = x->x_slot.state;
+	state = &render->state;
 
 	// Check if samplerate has changed
-	if(x->x_sr != sp[0]->s_sr){
+	if(state->sr != sp[0]->s_sr){
                 if(! sp[0]->s_sr){
                         error("zero sampling rate!");
                         return;
                 }
-                x->x_si *= x->x_sr / sp[0]->s_sr;
-                x->x_sr = sp[0]->s_sr;
-                x->x_sifactor = step / x->x_sr;
+                osc_randOsc_set_param(state, OSC_PARAM_SAMPLERATE, sp[0]->s_sr);
 	}
 
+	// Render with the restrict-qualified kernels, unless Pd gave an outlet the vector of an inlet
+	render->type = osc_type_select(randOsc_type, (const t_sample *const *) inputs, outputs, sp[0]->s_n);
+
 	/* Attach the object to the DSP chain, passing the DSP routine powSine_perform(),
 	inlet and outlet pointers, and the signal vector size */
-	dsp_add(randOsc_perform, 6, x, sp[0]->s_vec, sp[1]->s_vec, sp[2]->s_vec, sp[3]->s_vec, sp[0]->s_n);
+	dsp_add(randOsc_perform, 6, render, sp[0]->s_vec, sp[1]->s_vec, sp[2]->s_vec, sp[3]->s_vec, sp[0]->s_n);
 }
 
 // Method to reset oscillator's phase with float input in last inlet (control)
 void randOsc_ft1(t_randOsc *x, t_float f)
 {
-        float scale_input = (float) RANDOSC_STEPSIZE;
-        f *= scale_input;
-        x->x_phase = f;
+	randOsc_phase(x, f, 0);
+}
+
+// Method to reset oscillator's phase at a sample offset of the next block, the
+// reset is queued so it can be called from any one thread other than the audio one
+void randOsc_phase(t_randOsc *x, t_float f, t_float offset)
+{
+	t_randOsc_render *render = x->x_slot.state;
+	osc_event event;
+
+	event.param = OSC_PARAM_PHASE;
+	event.offset = offset;
+	event.value[0] = f;
+	event.value[1] = 0;
+	if(!osc_queue_push(&render->queue, &event))
+		pd_error(x, "randOsc~: too many messages in one block, phase reset dropped");
+}
+
+/* Method to switch the LFO mode on, computing the waveform every so many samples
+   and interpolating in between (lfo <samples>), or once per block (lfo block),
+   at a fraction of the cost. lfo 0 goes back to computing every sample */
+void randOsc_lfo(t_randOsc *x, t_symbol *s, int argc, t_atom *argv)
+{
+	t_randOsc_render *render = x->x_slot.state;
+	osc_event event;
+	(void) s;
+
+	event.param = OSC_PARAM_DECIMATE;
+	event.offset = 0;
+	if(atom_getsymbolarg(0, argc, argv) == gensym("block")) event.value[0] = -1;
+	else event.value[0] = (int) atom_getfloatarg(0, argc, argv);
+	event.value[1] = 0;
+	if(event.value[0] < -1) event.value[0] = 0;
+	if(!osc_queue_push(&render->queue, &event))
+		pd_error(x, "randOsc~: too many messages in one block, lfo dropped");
 }
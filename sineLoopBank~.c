@@ -0,0 +1,193 @@
+/*******************************************************************
+ *   [sineLoopBank~] a bank of [sineLoop~] feedback oscillators,   *
+ *   rendered side by side so that the voices share SIMD lanes     *
+ *******************************************************************/
+
+// Header files required by Pure Data
+#include "m_pd.h"
+// The oscillator kernels
+#include "various_oscillators.h"
+
+// Constant definitions
+#define SINELOOPBANK_DEFAULT_VOICES 8
+
+// The class pointer
+static t_class *sineLoopBank_class;
+
+// The object structure
+typedef struct _sineLoopBank {
+	// The Pd object
+	t_object obj;
+	// Convert floats to signals, the frequency ratio
+	t_float x_f;
+	// Rest of variables
+	int x_mc; // one output channel per voice instead of their sum
+	osc_sineLoopBank x_state; // the voices' states, see various_oscillators.h
+	osc_queue x_queue; // parameter changes on their way to the audio thread
+	osc_event x_events[OSC_QUEUE_SIZE]; // the changes themselves
+} t_sineLoopBank;
+
+// Function prototypes
+static void *sineLoopBank_new(t_symbol *s, int argc, t_atom *argv);
+static void sineLoopBank_dsp(t_sineLoopBank *x, t_signal **sp);
+static void sineLoopBank_freq(t_sineLoopBank *x, t_symbol *s, int argc, t_atom *argv);
+static void sineLoopBank_fb(t_sineLoopBank *x, t_symbol *s, int argc, t_atom *argv);
+static void sineLoopBank_phase(t_sineLoopBank *x, t_symbol *s, int argc, t_atom *argv);
+static void sineLoopBank_push(t_sineLoopBank *x, int param, int argc, t_atom *argv, const char *name);
+static t_int *sineLoopBank_perform(t_int *w);
+
+// The new instance routine
+static void *sineLoopBank_new(t_symbol *s, int argc, t_atom *argv)
+{
+	t_sineLoopBank *x = (t_sineLoopBank *) pd_new(sineLoopBank_class);
+	int nvoices = SINELOOPBANK_DEFAULT_VOICES;
+	(void) s;
+
+	// Check for creation arguments, the number of voices and the -mc flag
+	x->x_mc = 0;
+	for(; argc; argc--, argv++){
+		if(argv->a_type == A_FLOAT) nvoices = atom_getfloat(argv);
+		else if(argv->a_w.w_symbol == gensym("-mc")) {
+#ifdef CLASS_MULTICHANNEL
+			x->x_mc = 1;
+#else
+			pd_error(x, "sineLoopBank~: -mc needs a Pd with multichannel signals (0.54 or later)");
+#endif
+		}
+	}
+
+	// The frequency ratio all voices are multiplied by, 1 until something's connected
+	x->x_f = 1;
+
+	// Create a signal outlet, the mix of all voices or one channel per voice
+	outlet_new(&x->obj, gensym("signal"));
+
+	// Initialize the voices with the system's sampling rate
+	osc_sineLoopBank_init(&x->x_state, sys_getsr(), nvoices);
+	osc_queue_init(&x->x_queue, x->x_events);
+
+	// Return a pointer to the new object
+	return x;
+}
+
+// The perform routine
+static t_int *sineLoopBank_perform(t_int *w)
+{
+	// Copy the object pointer
+	t_sineLoopBank *x = (t_sineLoopBank *) (w[1]);
+
+	// Copy signal vector pointers, the frequency ratio and the output
+	t_sample *ratio = (t_sample *) (w[2]);
+	t_sample *out = (t_sample *) (w[3]);
+
+	// Copy the signal vector size
+	int n = w[4];
+
+	t_sample *outputs[OSC_SINELOOPBANK_MAXVOICES];
+	const osc_event *event;
+	int voice;
+
+	// Apply the messages received since the last block
+	while((event = osc_queue_front(&x->x_queue))) {
+		osc_sineLoopBank_set_param(&x->x_state, event->value[1], event->param, event->value[0]);
+		osc_queue_pop(&x->x_queue);
+	}
+
+	// Render all voices, into a channel each or added up
+	if(x->x_mc) {
+		for(voice = 0; voice < x->x_state.nvoices; voice++) outputs[voice] = out + (voice * n);
+		osc_sineLoopBank_render(&x->x_state, ratio, outputs, 0, n);
+	}
+	else osc_sineLoopBank_render(&x->x_state, ratio, 0, out, n);
+
+	// Return the next address in the DSP chain
+	return w + 5;
+}
+
+// The DSP method
+static void sineLoopBank_dsp(t_sineLoopBank *x, t_signal **sp)
+{
+	// Check if samplerate has changed
+	if(x->x_state.sr != sp[0]->s_sr){
+		if(! sp[0]->s_sr){
+			error("zero sampling rate!");
+			return;
+		}
+		osc_sineLoopBank_set_param(&x->x_state, -1, OSC_PARAM_SAMPLERATE, sp[0]->s_sr);
+	}
+
+#ifdef CLASS_MULTICHANNEL
+	// only the first channel of a multichannel ratio input is read
+	signal_setmultiout(&sp[1], x->x_mc ? x->x_state.nvoices : 1);
+#endif
+
+	/* Attach the object to the DSP chain, passing the DSP routine sineLoopBank_perform(),
+	inlet and outlet pointers, and the signal vector size */
+	dsp_add(sineLoopBank_perform, 4, x, sp[0]->s_vec, sp[1]->s_vec, sp[0]->s_n);
+}
+
+// The Pd class definition function
+void sineLoopBank_tilde_setup(void)
+{
+	// Initialize the class
+	sineLoopBank_class = class_new(gensym("sineLoopBank~"), (t_newmethod)(void (*)(void))sineLoopBank_new, 0, sizeof(t_sineLoopBank),
+#ifdef CLASS_MULTICHANNEL
+		CLASS_MULTICHANNEL,
+#else
+		0,
+#endif
+		A_GIMME, 0);
+
+	// Specify signal input, with automatic float to signal conversion
+	CLASS_MAINSIGNALIN(sineLoopBank_class, t_sineLoopBank, x_f);
+
+	// Bind the DSP method, which is called when the DACs are turned on
+	class_addmethod(sineLoopBank_class, (t_method)sineLoopBank_dsp, gensym("dsp"), A_CANT, 0);
+
+	// Bind the methods setting the voices' frequencies, feedback amounts and phases
+	class_addmethod(sineLoopBank_class, (t_method)sineLoopBank_freq, gensym("freq"), A_GIMME, 0);
+	class_addmethod(sineLoopBank_class, (t_method)sineLoopBank_fb, gensym("fb"), A_GIMME, 0);
+	class_addmethod(sineLoopBank_class, (t_method)sineLoopBank_phase, gensym("phase"), A_GIMME, 0);
+
+	// Print authorship to Pd window
+	post("sineLoopBank~: Bank of feedback sinewave oscillators");
+}
+
+// Queue a value for every voice, or a list of values for the voices from the first one on
+static void sineLoopBank_push(t_sineLoopBank *x, int param, int argc, t_atom *argv, const char *name)
+{
+	osc_event event;
+	int voice;
+
+	event.param = param;
+	event.offset = 0;
+	for(voice = 0; voice < argc; voice++){
+		event.value[0] = atom_getfloatarg(voice, argc, argv);
+		event.value[1] = argc == 1 ? -1 : voice;
+		if(!osc_queue_push(&x->x_queue, &event)) {
+			pd_error(x, "sineLoopBank~: too many messages in one block, %s dropped", name);
+			return;
+		}
+	}
+}
+
+// Method to set the voices' frequencies, one value sets all of them
+static void sineLoopBank_freq(t_sineLoopBank *x, t_symbol *s, int argc, t_atom *argv)
+{
+	(void) s;
+	sineLoopBank_push(x, OSC_PARAM_FREQUENCY, argc, argv, "freq");
+}
+
+// Method to set the voices' feedback amounts (0 - 1), one value sets all of them
+static void sineLoopBank_fb(t_sineLoopBank *x, t_symbol *s, int argc, t_atom *argv)
+{
+	(void) s;
+	sineLoopBank_push(x, OSC_PARAM_FEEDBACK, argc, argv, "fb");
+}
+
+// Method to reset the voices' phases (0 - 1), one value resets all of them
+static void sineLoopBank_phase(t_sineLoopBank *x, t_symbol *s, int argc, t_atom *argv)
+{
+	(void) s;
+	sineLoopBank_push(x, OSC_PARAM_PHASE, argc, argv, "phase");
+}
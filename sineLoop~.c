@@ -6,18 +6,21 @@
 
 // Header files required by Pure Data
 #include "m_pd.h"
-#include "math.h"
-
-// Constant definitions
-#define SINELOOP_STEP 512
+// The oscillator kernels
+#include "various_oscillators.h"
 
 // The class pointer
 static t_class *sineLoop_class;
 
-// lookup table pointer
-float *sine_tab;
+// The oscillator, rendered through each object's event queue
+static const osc_type *sineLoop_type;
 
-static float one_over_step = 1.0 / SINELOOP_STEP;
+// Everything sineLoop_perform() reads every block, in one piece so that it
+// takes a line or two of the arena, see sineLoop_dsp()
+typedef struct _sineLoop_render {
+	osc_queue queue; // parameter changes on their way to the audio thread
+	osc_sineLoop state; // the oscillator
+} t_sineLoop_render;
 
 // The object structure
 typedef struct _sineLoop {
@@ -26,20 +29,19 @@ typedef struct _sineLoop {
         // Convert floats to signals
        	t_float x_f;
       	// Rest of variables
-      	float x_frequency;
-      	// float x_power; // use this variable only after the argument problem is solved
-       	float x_phase;
-       	float x_si; // sample increment
-       	float x_sifactor; // factor for generating sampling increment
-       	float x_sr; // sampling rate
-        t_float x_last_sample;
+	osc_slot x_slot; // where x_render is now, perform is handed that address
+	t_float x_frequency;
+	// t_float x_power; // use this variable only after the argument problem is solved
+	t_sineLoop_render x_render; // what perform reads, while it's not in the arena, see x_slot
+	osc_event x_events[OSC_QUEUE_SIZE]; // the queue's events, only read when there are some
 } t_sineLoop;
 
 // Function prototypes
 static void *sineLoop_new(void);
+static void sineLoop_free(t_sineLoop *x);
 static void sineLoop_dsp(t_sineLoop *x, t_signal **sp);
 static void sineLoop_ft1(t_sineLoop *x, t_float f);
-static void make_cos_tab(void);
+static void sineLoop_phase(t_sineLoop *x, t_float f, t_float offset);
 static t_int *sineLoop_perform(t_int *w);
 
 // The new instance routine
@@ -57,76 +59,41 @@ static void *sineLoop_new(void)
   	// Create one signal outlet
   	outlet_new(&x->obj, gensym("signal"));
 
-	// Initialize phase and frequency to 0
-	x->x_phase = 0;
+	// Initialize frequency to 0
 	x->x_frequency = 0;
 
-	// get system's sampling rate and set sampling interval and factor
-	x->x_sr = sys_getsr();
-	x->x_sifactor = (float) SINELOOP_STEP / x->x_sr;
-	x->x_si = x->x_frequency * x->x_sifactor;
+	// Initialize the oscillator with the system's sampling rate
+	osc_sineLoop_init(&x->x_render.state, sys_getsr());
+	osc_queue_init(&x->x_render.queue, x->x_events);
+	osc_slot_init(&x->x_slot, &x->x_render, sizeof(x->x_render));
 
 	// Return a pointer to the new object
 	return x;
 }
 
+// The free method, taking the state out of the arena
+static void sineLoop_free(t_sineLoop *x)
+{
+	osc_slot_release(&x->x_slot);
+}
+
 // The perform routine
 static t_int *sineLoop_perform(t_int *w)
 {
 	// The first five variables are assigned values passed from the dsp method
 
-	// Copy the object pointer
-	t_sineLoop *x = (t_sineLoop *) (w[1]);
+	// Copy the pointer to what's rendered, in the arena or in the object
+	t_sineLoop_render *render = (t_sineLoop_render *) (w[1]);
 
-	// Copy signal vector pointers
-	t_float *frequency = (t_float *) (w[2]);
-	t_float *fb_amount = (t_float *) (w[3]);
-	t_float *out = (t_float *) (w[4]);
+	// Copy signal vector pointers, frequency and feedback amount
+	t_sample *inputs[OSC_SINELOOP_INPUTS] = { (t_sample *) (w[2]), (t_sample *) (w[3]) };
+	t_sample *outputs[OSC_SINELOOP_OUTPUTS] = { (t_sample *) (w[4]) };
 
 	// Copy the signal vector size
 	t_int n = w[5];
 
-	// Dereference components from the object structure
-  	t_float last_sample = x->x_last_sample;
-	float si_factor = x->x_sifactor;
-	float si = x->x_si;
-	float phase = x->x_phase;
-	// Local variables
-	float phase_local;
-  	float feedback;
-  	float frac;
-  	int int_part;
-	float step = (float) SINELOOP_STEP;
-
-	// Perform the DSP loop
-	while(n--){
-        // add it to the frequency
-		si = *frequency++ * si_factor;
-		// take the current out sample for the feedback
-    		feedback = *fb_amount++;
-    		// clip it
-    		if(feedback >= 1.0) feedback = 1.0;
-    		else if(feedback < 0.0) feedback = 0.0;
-    		feedback *= step;
-
-    		// wrap phase (copied from SineLoop code)
-    		if(phase < 0) phase += ((int)(-phase * one_over_step) + 1) * step;
-    		else if(phase >= step) phase -= (int)(phase * one_over_step) * step;
-
-    		// add the last sample with its index
-    		phase_local = phase + last_sample * feedback;
-    		// wrap local phase
-    		if(phase_local < 0) phase_local += ((int)(-phase_local * one_over_step) + 1) * step;
-    		else if(phase_local >= step) phase_local -= (int)(phase_local * one_over_step) * step;
-
-    		int_part = (int)phase_local;
-    		frac = phase_local - int_part;
-    		*out++ = last_sample = sine_tab[int_part] * (1.0 - frac) + sine_tab[int_part + 1] * frac;
-		phase += si;
-	}
-	// Update object's phase and last_sample variables
-	x->x_phase = phase;
-  	x->x_last_sample = last_sample;
+	// Render the block, applying the queued parameter changes, see libvarious_oscillators.c
+	osc_queue_render(&render->queue, sineLoop_type, &render->state, 0, (const t_sample *const *) inputs, outputs, n);
 
 	// Return the next address in the DSP chain
 	return w + 6;
@@ -135,48 +102,34 @@ static t_int *sineLoop_perform(t_int *w)
 // The DSP method
 static void sineLoop_dsp(t_sineLoop *x, t_signal **sp)
 {
-	// Set table length local variable
-	float step = (float) SINELOOP_STEP;
+	t_sineLoop_render *render;
+	osc_sineLoop *state;
+
+	// Move what perform reads next to the one placed before it in the chain, in this
+	// Pd instance's arena, and hand perform the address it ends up at
+	osc_slot_place(osc_arena_of(pd_this), &x->x_slot, clock_getlogicaltime());
+	render = x->x_slot.state;
+	state = &render->state;
 
 	// Check if samplerate has changed
-	if(x->x_sr != sp[0]->s_sr){
+	if(state->sr != sp[0]->s_sr){
                 if(! sp[0]->s_sr){
                         error("zero sampling rate!");
                         return;
                 }
-                x->x_si *= x->x_sr / sp[0]->s_sr;
-                x->x_sr = sp[0]->s_sr;
-                x->x_sifactor = step / x->x_sr;
+                osc_sineLoop_set_param(state, OSC_PARAM_SAMPLERATE, sp[0]->s_sr);
 	}
 
 	/* Attach the object to the DSP chain, passing the DSP routine powSine_perform(),
 	inlet and outlet pointers, and the signal vector size */
-	dsp_add(sineLoop_perform, 5, x, sp[0]->s_vec, sp[1]->s_vec, sp[2]->s_vec, sp[0]->s_n);
-}
-
-static void make_cos_tab(void)
-{
-  	int i;
-  	float *fp, phase, phsinc = (2. * 3.14159) / SINELOOP_STEP;
-
-  	// first check if a [sineLoop~] object has already been created
-  	// if it has, don't acquire memory, but use the already existing table
-  	if(sine_tab) return;
-  	// this is copied from [cos~]
-  	sine_tab = (float *)getbytes(sizeof(float) * (SINELOOP_STEP+1));
-
-  	for (i = 0, fp = sine_tab, phase = 0; i < SINELOOP_STEP; i++, fp++, phase += phsinc)
-	  *fp = cos(phase);
-
-  	// copy to first element to the last position of the table for interpolation
-  	sine_tab[SINELOOP_STEP] = sine_tab[0];
+	dsp_add(sineLoop_perform, 5, render, sp[0]->s_vec, sp[1]->s_vec, sp[2]->s_vec, sp[0]->s_n);
 }
 
 // The Pd class definition function
 void sineLoop_tilde_setup(void)
 {
 	// Initialize the class
-	sineLoop_class = class_new(gensym("sineLoop~"), (t_newmethod)sineLoop_new, 0, sizeof(t_sineLoop), 0, A_GIMME, 0);
+	sineLoop_class = class_new(gensym("sineLoop~"), (t_newmethod)sineLoop_new, (t_method)sineLoop_free, sizeof(t_sineLoop), 0, A_GIMME, 0);
 
 	// Specify signal input, with automatic float to signal conversion
 	CLASS_MAINSIGNALIN(sineLoop_class, t_sineLoop, x_f);
@@ -187,8 +140,11 @@ void sineLoop_tilde_setup(void)
 	// Bind the method to receive a float in the last inlet (control) to reset the phase
   	class_addmethod(sineLoop_class, (t_method)sineLoop_ft1, gensym("ft1"), A_FLOAT, 0);
 
-  	// fill in the lookup table
-  	make_cos_tab();
+	// Bind the method to reset the phase at a sample offset of the next block
+	class_addmethod(sineLoop_class, (t_method)sineLoop_phase, gensym("phase"), A_FLOAT, A_DEFFLOAT, 0);
+
+	// Look the oscillator up in the kernels' table
+	sineLoop_type = osc_type_find("sineLoop");
 
 	// Print authorship to Pd window
 	post("sineLoop~: Feedback sinewave oscillator\ncode translated from Pyo's SineLoop object source code\n external by Alexandros Drymonitis");
@@ -197,7 +153,20 @@ void sineLoop_tilde_setup(void)
 // Method to reset oscillator's phase with float input in last inlet (control)
 static void sineLoop_ft1(t_sineLoop *x, t_float f)
 {
-        float scale_input = (float) SINELOOP_STEP;
-        f *= scale_input;
-        x->x_phase = f;
+	sineLoop_phase(x, f, 0);
+}
+
+// Method to reset oscillator's phase at a sample offset of the next block, the
+// reset is queued so it can be called from any one thread other than the audio one
+static void sineLoop_phase(t_sineLoop *x, t_float f, t_float offset)
+{
+	t_sineLoop_render *render = x->x_slot.state;
+	osc_event event;
+
+	event.param = OSC_PARAM_PHASE;
+	event.offset = offset;
+	event.value[0] = f;
+	event.value[1] = 0;
+	if(!osc_queue_push(&render->queue, &event))
+		pd_error(x, "sineLoop~: too many messages in one block, phase reset dropped");
 }
@@ -0,0 +1,316 @@
+/****************************************************
+ * Wavetable oscillator reading band-limited mip    *
+ * levels of a Pd array, built on a background      *
+ * thread so redrawing the array never blocks DSP   *
+ ****************************************************/
+
+// Header files required by Pure Data
+#include "m_pd.h"
+#include <stdlib.h>
+#include <pthread.h>
+// The oscillator kernels
+#include "various_oscillators.h"
+
+// Constant definitions
+#define TABOSC_POLL 20 // ms between checks for finished and retired tables
+
+// The class pointer
+static t_class *tabOsc_class;
+
+// Everything tabOsc_perform() reads every block, in one piece so that it
+// takes a line or two of the arena, see tabOsc_dsp()
+typedef struct _tabOsc_render {
+	osc_queue queue; // parameter changes on their way to the audio thread
+	osc_wavetable *pending; // handed to perform, which swaps it in at the next block
+	osc_wavetable *retired; // swapped out by perform, freed by the clock
+	osc_tabOsc state; // the oscillator, its table is only touched by perform
+} t_tabOsc_render;
+
+// The object structure
+typedef struct _tabOsc {
+	// The Pd object
+        t_object obj;
+	// Convert floats to signals
+        t_float x_f;
+	// Rest of variables
+	osc_slot x_slot; // where x_render is now, perform is handed that address
+	t_symbol *x_arrayname;
+	t_tabOsc_render x_render; // what perform reads, while it's not in the arena, see x_slot
+	osc_event x_events[OSC_QUEUE_SIZE]; // the queue's events, only read when there are some
+	// The table building, see tabOsc_build()
+	pthread_t x_thread;
+	int x_building; // a thread is running
+	int x_done; // set by the thread when its table is ready
+	int x_again; // the array was set again while building
+	osc_sample *x_cycle; // copy of the array for the thread
+	int x_cyclesize;
+	osc_wavetable *x_built; // the thread's result
+	t_clock *x_clock;
+} t_tabOsc;
+
+// Function prototypes
+void *tabOsc_new(t_symbol *s);
+void tabOsc_free(t_tabOsc *x);
+void tabOsc_dsp(t_tabOsc *x, t_signal **sp);
+void tabOsc_ft1(t_tabOsc *x, t_float f);
+void tabOsc_phase(t_tabOsc *x, t_float f, t_float offset);
+void tabOsc_set(t_tabOsc *x, t_symbol *s);
+void tabOsc_bang(t_tabOsc *x);
+t_int *tabOsc_perform(t_int *w);
+static void tabOsc_build(t_tabOsc *x);
+static void tabOsc_tick(t_tabOsc *x);
+
+// The Pd class definition function
+void tabOsc_tilde_setup(void)
+{
+	// Initialize the class
+	tabOsc_class = class_new(gensym("tabOsc~"), (t_newmethod)(void (*)(void))tabOsc_new, (t_method)tabOsc_free, sizeof(t_tabOsc), 0, A_DEFSYM, 0);
+
+	// Specify signal input, with automatic float to signal conversion
+	CLASS_MAINSIGNALIN(tabOsc_class, t_tabOsc, x_f);
+
+	// Bind the DSP method, which is called when the DACs are turned on
+	class_addmethod(tabOsc_class, (t_method)tabOsc_dsp, gensym("dsp"), A_CANT, 0);
+
+	// Bind the method to receive a float in the last inlet (control) to reset the phase
+        class_addmethod(tabOsc_class, (t_method)tabOsc_ft1, gensym("ft1"), A_FLOAT, 0);
+
+	// Bind the method to reset the phase at a sample offset of the next block
+	class_addmethod(tabOsc_class, (t_method)tabOsc_phase, gensym("phase"), A_FLOAT, A_DEFFLOAT, 0);
+
+	// Bind the methods to choose an array, and to read it again after it's been redrawn
+	class_addmethod(tabOsc_class, (t_method)tabOsc_set, gensym("set"), A_SYMBOL, 0);
+	class_addbang(tabOsc_class, (t_method)tabOsc_bang);
+
+	// Print authorship to Pd window
+	post("tabOsc~: Band-limited wavetable oscillator");
+}
+
+// The new instance routine
+void *tabOsc_new(t_symbol *s)
+{
+	// Instantiate a new tabOsc~ object
+	t_tabOsc *x = (t_tabOsc *) pd_new(tabOsc_class);
+
+	// Create one additional signal inlet and one control inlet, the first one is on the house
+        inlet_new(&x->obj, &x->obj.ob_pd, gensym("signal"), gensym("signal"));
+	inlet_new(&x->obj, &x->obj.ob_pd, &s_float, gensym("ft1"));
+
+        // Create a signal outlet
+        outlet_new(&x->obj, gensym("signal"));
+
+	// The array is read when the DSP starts, as it may not exist yet
+	x->x_arrayname = s;
+
+	// Initialize the oscillator with the system's sampling rate
+	osc_tabOsc_init(&x->x_render.state, sys_getsr());
+	osc_queue_init(&x->x_render.queue, x->x_events);
+	x->x_render.pending = x->x_render.retired = 0;
+	osc_slot_init(&x->x_slot, &x->x_render, sizeof(x->x_render));
+
+	x->x_building = x->x_done = x->x_again = 0;
+	x->x_cycle = 0;
+	x->x_cyclesize = 0;
+	x->x_built = 0;
+	x->x_clock = clock_new(x, (t_method)tabOsc_tick);
+
+	// Return a pointer to the new object
+	return x;
+}
+
+void tabOsc_free(t_tabOsc *x)
+{
+	clock_free(x->x_clock);
+	if(x->x_building) pthread_join(x->x_thread, 0);
+	if(x->x_cycle) freebytes(x->x_cycle, sizeof(osc_sample) * x->x_cyclesize);
+	osc_slot_release(&x->x_slot);
+	osc_wavetable_free(x->x_built);
+	osc_wavetable_free(x->x_render.pending);
+	osc_wavetable_free(x->x_render.retired);
+	osc_wavetable_free((osc_wavetable *) x->x_render.state.table);
+}
+
+// The perform routine
+t_int *tabOsc_perform(t_int *w)
+{
+	// The first five variables are assigned values passed from the dsp method
+
+	// Copy the pointer to what's rendered, in the arena or in the object
+	t_tabOsc_render *render = (t_tabOsc_render *) (w[1]);
+
+	// Copy signal vector pointers, frequency and phase modulation
+	t_sample *inputs[OSC_TABOSC_INPUTS] = { (t_sample *) (w[2]), (t_sample *) (w[3]) };
+	t_sample *outputs[OSC_TABOSC_OUTPUTS] = { (t_sample *) (w[4]) };
+
+	// Copy the signal vector size
+	t_int n = w[5];
+
+	// Swap in a newly built table, handing the old one to the clock to free it.
+	// The clock empties retired before it hands out the next table, so
+	// there's never an old one left here that this thread would have to free
+	osc_wavetable *table = __atomic_exchange_n(&render->pending, 0, __ATOMIC_ACQ_REL);
+	if(table) {
+		__atomic_store_n(&render->retired, (osc_wavetable *) render->state.table, __ATOMIC_RELEASE);
+		render->state.table = table;
+	}
+
+	// Render the block, applying the queued parameter changes, see libvarious_oscillators.c
+	osc_queue_render(&render->queue, &osc_tabOsc_type, &render->state, 0, (const t_sample *const *) inputs, outputs, n);
+
+	// Return the next address in the DSP chain
+	return w + 6;
+}
+
+// The DSP method
+void tabOsc_dsp(t_tabOsc *x, t_signal **sp)
+{
+	t_tabOsc_render *render;
+	osc_tabOsc *state;
+
+	// Move what perform reads next to the one placed before it in the chain, in this
+	// Pd instance's arena, and hand perform the address it ends up at
+	osc_slot_place(osc_arena_of(pd_this), &x->x_slot, clock_getlogicaltime());
+	render = x->x_slot.state;
+	state = &render->state;
+
+	// Check if samplerate has changed
+	if(state->sr != sp[0]->s_sr){
+                if(! sp[0]->s_sr){
+                        error("zero sampling rate!");
+                        return;
+                }
+                osc_tabOsc_set_param(state, OSC_PARAM_SAMPLERATE, sp[0]->s_sr);
+	}
+
+	// Read the array the first time the DSP starts, like [tabread4~] does
+	if(!state->table && !x->x_building && !__atomic_load_n(&render->pending, __ATOMIC_ACQUIRE) &&
+		*x->x_arrayname->s_name)
+		tabOsc_build(x);
+
+	// the clock stops checking once a table's only waiting for perform, so that it
+	// doesn't poll while the DSP is off, start it again to free the one it replaces
+	else if(__atomic_load_n(&render->pending, __ATOMIC_ACQUIRE) ||
+		__atomic_load_n(&render->retired, __ATOMIC_ACQUIRE))
+		clock_delay(x->x_clock, TABOSC_POLL);
+
+	/* Attach the object to the DSP chain, passing the DSP routine tabOsc_perform(),
+	inlet and outlet pointers, and the signal vector size */
+	dsp_add(tabOsc_perform, 5, render, sp[0]->s_vec, sp[1]->s_vec, sp[2]->s_vec, sp[0]->s_n);
+}
+
+// The table building thread, this is the slow part
+static void *tabOsc_thread(void *arg)
+{
+	t_tabOsc *x = (t_tabOsc *) arg;
+
+	x->x_built = osc_wavetable_new(x->x_cycle, x->x_cyclesize);
+	__atomic_store_n(&x->x_done, 1, __ATOMIC_RELEASE);
+	return 0;
+}
+
+// Copy the array and start a thread building its table
+static void tabOsc_build(t_tabOsc *x)
+{
+	t_garray *array;
+	t_word *vec;
+	int i, size;
+
+	// one build at a time, the latest array is read once this one is done
+	if(x->x_building) {
+		x->x_again = 1;
+		return;
+	}
+	if(!(array = (t_garray *) pd_findbyclass(x->x_arrayname, garray_class))) {
+		pd_error(x, "tabOsc~: %s: no such array", x->x_arrayname->s_name);
+		return;
+	}
+	if(!garray_getfloatwords(array, &size, &vec) || size < 1) {
+		pd_error(x, "tabOsc~: %s: bad template for tabOsc~", x->x_arrayname->s_name);
+		return;
+	}
+
+	// the array can only be read here, the thread gets a copy
+	x->x_cycle = (osc_sample *) getbytes(sizeof(osc_sample) * size);
+	x->x_cyclesize = size;
+	for(i = 0; i < size; i++) x->x_cycle[i] = vec[i].w_float;
+	x->x_done = 0;
+	if(pthread_create(&x->x_thread, 0, tabOsc_thread, x)) {
+		pd_error(x, "tabOsc~: can't start a thread to build the table");
+		freebytes(x->x_cycle, sizeof(osc_sample) * size);
+		x->x_cycle = 0;
+		return;
+	}
+	x->x_building = 1;
+	clock_delay(x->x_clock, TABOSC_POLL);
+}
+
+// The clock, collecting finished tables and freeing retired ones
+static void tabOsc_tick(t_tabOsc *x)
+{
+	t_tabOsc_render *render = x->x_slot.state;
+	osc_wavetable *table;
+	int handed = 0;
+
+	// free the table perform has swapped out, before handing out another one
+	table = __atomic_exchange_n(&render->retired, 0, __ATOMIC_ACQ_REL);
+	osc_wavetable_free(table);
+
+	if(x->x_building && __atomic_load_n(&x->x_done, __ATOMIC_ACQUIRE)) {
+		pthread_join(x->x_thread, 0);
+		x->x_building = 0;
+		freebytes(x->x_cycle, sizeof(osc_sample) * x->x_cyclesize);
+		x->x_cycle = 0;
+		if(x->x_built) {
+			// a table perform never picked up (the DSP is off) is replaced
+			table = __atomic_exchange_n(&render->pending, x->x_built, __ATOMIC_ACQ_REL);
+			osc_wavetable_free(table);
+			x->x_built = 0;
+			handed = 1;
+		}
+		else pd_error(x, "tabOsc~: %s: out of memory building the table", x->x_arrayname->s_name);
+		if(x->x_again) {
+			x->x_again = 0;
+			tabOsc_build(x);
+		}
+	}
+
+	// keep checking while a table's being built or waiting to be freed, and once
+	// more after handing one out, for the one perform swaps out. A table perform
+	// hasn't picked up by then is left to it, see tabOsc_dsp()
+	if(x->x_building || handed || __atomic_load_n(&render->retired, __ATOMIC_ACQUIRE))
+		clock_delay(x->x_clock, TABOSC_POLL);
+}
+
+// Method to reset oscillator's phase with float input in last inlet (control)
+void tabOsc_ft1(t_tabOsc *x, t_float f)
+{
+	tabOsc_phase(x, f, 0);
+}
+
+// Method to reset oscillator's phase at a sample offset of the next block, the
+// reset is queued so it can be called from any one thread other than the audio one
+void tabOsc_phase(t_tabOsc *x, t_float f, t_float offset)
+{
+	t_tabOsc_render *render = x->x_slot.state;
+	osc_event event;
+
+	event.param = OSC_PARAM_PHASE;
+	event.offset = offset;
+	event.value[0] = f;
+	event.value[1] = 0;
+	if(!osc_queue_push(&render->queue, &event))
+		pd_error(x, "tabOsc~: too many messages in one block, phase reset dropped");
+}
+
+// Method to read another array
+void tabOsc_set(t_tabOsc *x, t_symbol *s)
+{
+	x->x_arrayname = s;
+	tabOsc_build(x);
+}
+
+// Method to read the array again, after it's been redrawn
+void tabOsc_bang(t_tabOsc *x)
+{
+	tabOsc_build(x);
+}
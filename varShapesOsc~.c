@@ -5,14 +5,24 @@
 
 // Header files required by Pure Data
 #include "m_pd.h"
-#include "math.h"
-
-// Constant definitions
-#define VARSHAPES_STEPSIZE 8192
+// The oscillator kernels
+#include "various_oscillators.h"
 
 // The class pointer
 static t_class *varShapesOsc_class;
 
+// The oscillator, rendered through each object's event queue
+static const osc_type *varShapesOsc_type;
+
+// Everything varShapesOsc_perform() reads every block, in one piece so that it
+// takes a line or two of the arena, see varShapesOsc_dsp()
+typedef struct _varShapesOsc_render {
+	const osc_type *type; // varShapesOsc_type, or its kernels for vectors that don't overlap
+	osc_queue queue; // parameter changes on their way to the audio thread
+	osc_varShapesOsc state; // the oscillator
+	osc_decimator decimator; // LFO mode, see varShapesOsc_lfo()
+} t_varShapesOsc_render;
+
 // The object structure
 typedef struct _varShapesOsc {
 	// The Pd object
@@ -20,25 +30,26 @@ typedef struct _varShapesOsc {
 	// Convert floats to signals
         t_float x_f;
 	// Rest of variables
-	float x_frequency;
-        float x_phase;
-        float x_si; // sample increment
-        float x_sifactor; // factor for generating sampling increment
-        float x_twopi;
-        float x_sr; // sampling rate
+	osc_slot x_slot; // where x_render is now, perform is handed that address
+	t_float x_frequency;
+	t_varShapesOsc_render x_render; // what perform reads, while it's not in the arena, see x_slot
+	osc_event x_events[OSC_QUEUE_SIZE]; // the queue's events, only read when there are some
 } t_varShapesOsc;
 
 // Function prototypes
-void *varShapesOsc_new(void);
+void *varShapesOsc_new(t_symbol *s, int argc, t_atom *argv);
+void varShapesOsc_free(t_varShapesOsc *x);
 void varShapesOsc_dsp(t_varShapesOsc *x, t_signal **sp);
 void varShapesOsc_ft1(t_varShapesOsc *x, t_float f);
+void varShapesOsc_phase(t_varShapesOsc *x, t_float f, t_float offset);
+void varShapesOsc_lfo(t_varShapesOsc *x, t_symbol *s, int argc, t_atom *argv);
 t_int *varShapesOsc_perform(t_int *w);
 
 // The Pd class definition function
 void varShapesOsc_tilde_setup(void)
 {
 	// Initialize the class
-	varShapesOsc_class = class_new(gensym("varShapesOsc~"), (t_newmethod)varShapesOsc_new, 0, sizeof(t_varShapesOsc), 0, A_GIMME, 0);
+	varShapesOsc_class = class_new(gensym("varShapesOsc~"), (t_newmethod)(void (*)(void))varShapesOsc_new, (t_method)varShapesOsc_free, sizeof(t_varShapesOsc), 0, A_GIMME, 0);
 
 	// Specify signal input, with automatic float to signal conversion
 	CLASS_MAINSIGNALIN(varShapesOsc_class, t_varShapesOsc, x_f);
@@ -49,12 +60,21 @@ void varShapesOsc_tilde_setup(void)
 	// Bind the method to receive a float in the last inlet (control) to reset the phase
         class_addmethod(varShapesOsc_class, (t_method)varShapesOsc_ft1, gensym("ft1"), A_FLOAT, 0);
 
+	// Bind the method to reset the phase at a sample offset of the next block
+	class_addmethod(varShapesOsc_class, (t_method)varShapesOsc_phase, gensym("phase"), A_FLOAT, A_DEFFLOAT, 0);
+
+	// Bind the method to switch the LFO mode on and off
+	class_addmethod(varShapesOsc_class, (t_method)varShapesOsc_lfo, gensym("lfo"), A_GIMME, 0);
+
+	// Look the oscillator up in the kernels' table
+	varShapesOsc_type = osc_type_find("varShapesOsc");
+
 	// Print authorship to Pd window
 	post("varShapesOsc~: Various shapes oscillator\n external by Alexandros Drymonitis");
 }
 
 // The new instance routine
-void *varShapesOsc_new(void)
+void *varShapesOsc_new(t_symbol *s, int argc, t_atom *argv)
 {
 	// Basic object setup
 
@@ -84,96 +104,47 @@ void *varShapesOsc_new(void)
 	if(argc >= 5) { x->x_xfade = atom_getfloatarg(4, argc, argv); }
 	*/
 
-	// Initialize phase and frequency to 0
-	x->x_phase = 0;
+	// Initialize frequency to 0
 	x->x_frequency = 0;
 
-	// define twoPi
-	x->x_twopi = 8.0 * atan(1.0);
+	// Initialize the oscillator with the system's sampling rate
+	osc_varShapesOsc_init(&x->x_render.state, sys_getsr());
+	osc_queue_init(&x->x_render.queue, x->x_events);
+	x->x_render.type = varShapesOsc_type;
+	osc_slot_init(&x->x_slot, &x->x_render, sizeof(x->x_render));
 
-	// get system's sampling rate and set sampling interval and factor
-	x->x_sr = sys_getsr();
-	x->x_sifactor = (float) VARSHAPES_STEPSIZE / x->x_sr;
-	x->x_si = x->x_frequency * x->x_sifactor;
+	// The only creation argument is the LFO mode, -lfo <samples> or -lfo block
+	osc_decimator_init(&x->x_render.decimator, 0);
+	if(argc >= 2 && atom_getsymbolarg(0, argc, argv) == gensym("-lfo"))
+		varShapesOsc_lfo(x, s, argc - 1, argv + 1);
 
 	// Return a pointer to the new object
 	return x;
 }
 
+// The free method, taking the state out of the arena
+void varShapesOsc_free(t_varShapesOsc *x)
+{
+	osc_slot_release(&x->x_slot);
+}
+
 // The perform routine
 t_int *varShapesOsc_perform(t_int *w)
 {
-	// The first six variables are assigned values passed from the dsp method
+	// The first nine variables are assigned values passed from the dsp method
 
-	// Copy the object pointer
-	t_varShapesOsc *x = (t_varShapesOsc *) (w[1]);
+	// Copy the pointer to what's rendered, in the arena or in the object
+	t_varShapesOsc_render *render = (t_varShapesOsc_render *) (w[1]);
 
-	// Copy signal vector pointers
-	t_float *frequency = (t_float *) (w[2]);
-	t_float *phase_mod = (t_float *) (w[3]);
-	t_float *xfade = (t_float *) (w[4]);
-	t_float *breakpoint = (t_float *) (w[5]);
-	t_float *rise_power = (t_float *) (w[6]);
-	t_float *fall_power = (t_float *) (w[7]);
-	t_float *out = (t_float *) (w[8]);
+	// Copy signal vector pointers, frequency, phase modulation, xfade, breakpoint, rise and fall power
+	t_sample *inputs[OSC_VARSHAPESOSC_INPUTS] = { (t_sample *) (w[2]), (t_sample *) (w[3]), (t_sample *) (w[4]), (t_sample *) (w[5]), (t_sample *) (w[6]), (t_sample *) (w[7]) };
+	t_sample *outputs[OSC_VARSHAPESOSC_OUTPUTS] = { (t_sample *) (w[8]) };
 
 	// Copy the signal vector size
 	t_int n = w[9];
 
-	// Dereference components from the object structure
-	float si_factor = x->x_sifactor;
-	float si = x->x_si;
-	float phase = x->x_phase;
-	float twopi = x->x_twopi;
-	// Local variables
-        float step = (float) VARSHAPES_STEPSIZE;
-	float breakpoint_local, invert_brk;
-	float xfade_local, invert_xfade;
-	float cos_phase, tri_phase;
-	float rise_power_local, fall_power_local;
-	float cos_tri_add, power_add;
-	float phase_add;
-	int phase_trunc;
-	float phase_wrap;
-
-	// Perform the DSP loop
-	while(n--){
-		breakpoint_local = *breakpoint++;
-		invert_brk = 1 - breakpoint_local;
-		xfade_local = *xfade++;
-		invert_xfade = 1 - xfade_local;
-		rise_power_local = *rise_power++;
-		fall_power_local = *fall_power++;
-		si = *frequency++ * si_factor;
-		// This is kind of copied from [wrap~]'s code
-		phase_add = ((phase / step) + *phase_mod++);
-		phase_trunc = phase_add;
-		if(phase_add > 0) phase_wrap = phase_add - phase_trunc;
-		else phase_wrap = phase_add - (phase_trunc - 1);
-		// [wrap]'s code was up to line above
-		if(phase_wrap < breakpoint_local) {
-			cos_phase = ((phase_wrap / breakpoint_local) * 0.5) + 0.5;
-			tri_phase = phase_wrap / breakpoint_local;
-			fall_power_local = 0;
-		}
-		else {
-			cos_phase = ((phase_wrap - breakpoint_local) / invert_brk) * 0.5;
-			tri_phase = (invert_brk - (phase_wrap - breakpoint_local)) / invert_brk;
-			rise_power_local = 0;
-		}
-		cos_tri_add = (((cos(twopi * cos_phase) * 0.5) + 0.5) * invert_xfade) + (tri_phase * xfade_local);
-		power_add = rise_power_local + fall_power_local;
-		*out++ = (pow(cos_tri_add, power_add) * 2) - 1;
-		phase += si;
-		while(phase > step) {
-			phase -= step;
-		}
-		while(phase < 0) {
-			phase += step;
-		}
-	}
-	// Update object's phase variable
-	x->x_phase = phase;
+	// Render the block, applying the queued parameter changes, see libvarious_oscillators.c
+	osc_queue_render(&render->queue, render->type, &render->state, &render->decimator, (const t_sample *const *) inputs, outputs, n);
 
 	// Return the next address in the DSP chain
 	return w + 10;
@@ -182,29 +153,70 @@ t_int *varShapesOsc_perform(t_int *w)
 // The DSP method
 void varShapesOsc_dsp(t_varShapesOsc *x, t_signal **sp)
 {
-	// Set table length local variable
-	float step = (float) VARSHAPES_STEPSIZE;
+	t_varShapesOsc_render *render;
+	osc_varShapesOsc *state;
+	t_sample *inputs[OSC_VARSHAPESOSC_INPUTS] = { sp[0]->s_vec, sp[1]->s_vec, sp[2]->s_vec, sp[3]->s_vec, sp[4]->s_vec, sp[5]->s_vec };
+	t_sample *outputs[OSC_VARSHAPESOSC_OUTPUTS] = { sp[6]->s_vec };
+
+	// Move what perform reads next to the one placed before it in the chain, in this
+	// Pd instance's arena, and hand perform the address it ends up at
+	osc_slot_place(osc_arena_of(pd_this), &x->x_slot, clock_getlogicaltime());
+	render = x->x_slot.state;
+	state = &render->state;
 
 	// Check if samplerate has changed
-	if(x->x_sr != sp[0]->s_sr){
+	if(state->sr != sp[0]->s_sr){
                 if(! sp[0]->s_sr){
                         error("zero sampling rate!");
                         return;
                 }
-                x->x_si *= x->x_sr / sp[0]->s_sr;
-                x->x_sr = sp[0]->s_sr;
-                x->x_sifactor = step / x->x_sr;
+                osc_varShapesOsc_set_param(state, OSC_PARAM_SAMPLERATE, sp[0]->s_sr);
 	}
 
+	// Render with the restrict-qualified kernels, unless Pd gave an outlet the vector of an inlet
+	render->type = osc_type_select(varShapesOsc_type, (const t_sample *const *) inputs, outputs, sp[0]->s_n);
+
 	/* Attach the object to the DSP chain, passing the DSP routine powSine_perform(),
 	inlet and outlet pointers, and the signal vector size */
-	dsp_add(varShapesOsc_perform, 9, x, sp[0]->s_vec, sp[1]->s_vec, sp[2]->s_vec, sp[3]->s_vec, sp[4]->s_vec, sp[5]->s_vec, sp[6]->s_vec, sp[0]->s_n);
+	dsp_add(varShapesOsc_perform, 9, render, sp[0]->s_vec, sp[1]->s_vec, sp[2]->s_vec, sp[3]->s_vec, sp[4]->s_vec, sp[5]->s_vec, sp[6]->s_vec, sp[0]->s_n);
 }
 
 // Method to reset oscillator's phase with float input in last inlet (control)
 void varShapesOsc_ft1(t_varShapesOsc *x, t_float f)
 {
-        float scale_input = (float) VARSHAPES_STEPSIZE;
-        f *= scale_input;
-        x->x_phase = f;
+	varShapesOsc_phase(x, f, 0);
+}
+
+// Method to reset oscillator's phase at a sample offset of the next block, the
+// reset is queued so it can be called from any one thread other than the audio one
+void varShapesOsc_phase(t_varShapesOsc *x, t_float f, t_float offset)
+{
+	t_varShapesOsc_render *render = x->x_slot.state;
+	osc_event event;
+
+	event.param = OSC_PARAM_PHASE;
+	event.offset = offset;
+	event.value[0] = f;
+	event.value[1] = 0;
+	if(!osc_queue_push(&render->queue, &event))
+		pd_error(x, "varShapesOsc~: too many messages in one block, phase reset dropped");
+}
+
+/* Method to switch the LFO mode on, computing the waveform every so many samples
+   and interpolating in between (lfo <samples>), or once per block (lfo block),
+   at a fraction of the cost. lfo 0 goes back to computing every sample */
+void varShapesOsc_lfo(t_varShapesOsc *x, t_symbol *s, int argc, t_atom *argv)
+{
+	t_varShapesOsc_render *render = x->x_slot.state;
+	osc_event event;
+	(void) s;
+
+	event.param = OSC_PARAM_DECIMATE;
+	event.offset = 0;
+	if(atom_getsymbolarg(0, argc, argv) == gensym("block")) event.value[0] = -1;
+	else event.value[0] = (int) atom_getfloatarg(0, argc, argv);
+	event.value[1] = 0;
+	if(event.value[0] < -1) event.value[0] = 0;
+	if(!osc_queue_push(&render->queue, &event))
+		pd_error(x, "varShapesOsc~: too many messages in one block, lfo dropped");
 }
@@ -0,0 +1,324 @@
+/***************************************************
+ * Host-independent API of the various oscillators *
+ * library. The Pd objects are thin wrappers around *
+ * it, but it doesn't depend on m_pd.h so the same *
+ * kernels can be embedded in any C/C++ host       *
+ ***************************************************/
+
+#ifndef VARIOUS_OSCILLATORS_H
+#define VARIOUS_OSCILLATORS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The sample type follows Pd's PD_FLOATSIZE when that is defined (include
+// m_pd.h first), so osc_sample and t_sample are always the same type.
+// Other hosts can define OSC_FLOATSIZE to 32 or 64 themselves
+#ifndef OSC_FLOATSIZE
+#ifdef PD_FLOATSIZE
+#define OSC_FLOATSIZE PD_FLOATSIZE
+#else
+#define OSC_FLOATSIZE 32
+#endif
+#endif
+
+#if OSC_FLOATSIZE == 64
+typedef double osc_sample;
+#else
+typedef float osc_sample;
+#endif
+
+// Built with OSC_FIXED defined (make OSC_FIXED=1), the oscillators compute in
+// fixed point, see libvarious_oscillators.c. Their phases are then 32 bit
+// integers a whole cycle wraps around (Q0.32), and the samples they keep from
+// one block to the next are Q2.30 (1 is 1 << 30). Inputs and outputs are
+// osc_sample either way
+#ifdef OSC_FIXED
+#include <stdint.h>
+typedef uint32_t osc_phase;
+typedef int32_t osc_value;
+#else
+typedef osc_sample osc_phase;
+typedef osc_sample osc_value;
+#endif
+
+// Parameters that can be set with the *_set_param() functions, all other
+// parameters are signal inputs passed to the *_render() functions
+enum {
+	OSC_PARAM_SAMPLERATE, // change the sampling rate, keeping the phase
+	OSC_PARAM_PHASE, // reset the phase (0 - 1)
+	OSC_PARAM_BANDLIMIT, // [powSine~] only, non-zero renders from band-limited tables
+	OSC_PARAM_SEED, // [randOsc~] only, reseed the random generator
+	OSC_PARAM_DECIMATE, // not for the oscillators, see osc_decimator below
+	OSC_PARAM_FREQUENCY, // [sineLoopBank~] voices only, in Hz
+	OSC_PARAM_FEEDBACK // [sineLoopBank~] voices only, feedback amount (0 - 1)
+};
+
+/* Every oscillator has the same four functions:
+   osc_<name>_init(state, sr) sets the state up for a sampling rate
+   osc_<name>_set_param(state, param, value) sets one of the parameters above
+   osc_<name>_render(state, inputs, outputs, n) renders n samples, reading one
+   vector per input and writing one vector per output, in the order of the Pd
+   object's signal inlets and outlets. Inputs and outputs may be the same vectors,
+   see osc_type_select() for the faster render functions of those that aren't */
+
+// Sinewave oscillator raised to a power
+// inputs: frequency, phase modulation, power
+#define OSC_POWSINE_INPUTS 3
+#define OSC_POWSINE_OUTPUTS 1
+typedef struct _osc_powSine {
+	osc_phase phase;
+	osc_sample si; // sample increment
+	osc_sample sifactor; // factor for generating sampling increment
+	osc_sample sr; // sampling rate
+	int sign; // variable to control the direction of each cycle
+	int bandlimit; // render from the band-limited tables instead of pow(cos())
+} osc_powSine;
+
+void osc_powSine_init(osc_powSine *x, osc_sample sr);
+void osc_powSine_set_param(osc_powSine *x, int param, osc_sample value);
+void osc_powSine_render(osc_powSine *x, const osc_sample *const *inputs, osc_sample *const *outputs, int n);
+
+// Random oscillator (not white noise)
+// inputs: frequency, xfade between cosine and triangle ramps, power
+#define OSC_RANDOSC_INPUTS 3
+#define OSC_RANDOSC_OUTPUTS 1
+typedef struct _osc_randOsc {
+	osc_phase phase;
+	osc_value random_sample, old_random_sample;
+	osc_sample si; // sample increment
+	osc_sample sifactor; // factor for generating sampling increment
+	osc_sample sr; // sampling rate
+	int randval; // state of the random number generator
+} osc_randOsc;
+
+void osc_randOsc_init(osc_randOsc *x, osc_sample sr);
+void osc_randOsc_set_param(osc_randOsc *x, int param, osc_sample value);
+void osc_randOsc_render(osc_randOsc *x, const osc_sample *const *inputs, osc_sample *const *outputs, int n);
+
+// Various shapes oscillator
+// inputs: frequency, phase modulation, xfade, breakpoint, rise power, fall power
+#define OSC_VARSHAPESOSC_INPUTS 6
+#define OSC_VARSHAPESOSC_OUTPUTS 1
+typedef struct _osc_varShapesOsc {
+	osc_phase phase;
+	osc_sample si; // sample increment
+	osc_sample sifactor; // factor for generating sampling increment
+	osc_sample sr; // sampling rate
+} osc_varShapesOsc;
+
+void osc_varShapesOsc_init(osc_varShapesOsc *x, osc_sample sr);
+void osc_varShapesOsc_set_param(osc_varShapesOsc *x, int param, osc_sample value);
+void osc_varShapesOsc_render(osc_varShapesOsc *x, const osc_sample *const *inputs, osc_sample *const *outputs, int n);
+
+// All four standard waveforms oscillator
+// inputs: frequency, phase modulation, duty cycle
+// outputs: cosine, triangle, sawtooth, square
+#define OSC_ALLOSC_INPUTS 3
+#define OSC_ALLOSC_OUTPUTS 4
+typedef struct _osc_allOsc {
+	osc_phase phase;
+	osc_sample si; // sample increment
+	osc_sample sifactor; // factor for generating sampling increment
+	osc_sample sr; // sampling rate
+} osc_allOsc;
+
+void osc_allOsc_init(osc_allOsc *x, osc_sample sr);
+void osc_allOsc_set_param(osc_allOsc *x, int param, osc_sample value);
+void osc_allOsc_render(osc_allOsc *x, const osc_sample *const *inputs, osc_sample *const *outputs, int n);
+
+// Feedback sinewave oscillator
+// inputs: frequency, feedback amount (0 - 1)
+#define OSC_SINELOOP_INPUTS 2
+#define OSC_SINELOOP_OUTPUTS 1
+typedef struct _osc_sineLoop {
+	osc_phase phase;
+	osc_sample si; // sample increment
+	osc_sample sifactor; // factor for generating sampling increment
+	osc_sample sr; // sampling rate
+	osc_value last_sample;
+} osc_sineLoop;
+
+void osc_sineLoop_init(osc_sineLoop *x, osc_sample sr);
+void osc_sineLoop_set_param(osc_sineLoop *x, int param, osc_sample value);
+void osc_sineLoop_render(osc_sineLoop *x, const osc_sample *const *inputs, osc_sample *const *outputs, int n);
+
+// A bank of [sineLoop~] voices, each one sounding like a [sineLoop~] of its own.
+// The feedback makes every sample of a voice wait for the one before, but the
+// voices don't wait for each other, so their states are kept in arrays and
+// rendered OSC_SINELOOPBANK_LANES voices side by side, one per SIMD lane.
+// inputs: a frequency ratio all voices are multiplied by; the voices' frequencies
+// and feedback amounts are parameters, set per voice
+#define OSC_SINELOOPBANK_LANES 8
+#define OSC_SINELOOPBANK_MAXVOICES 64 // a multiple of the lanes
+typedef struct _osc_sineLoopBank {
+	int nvoices;
+	osc_sample sifactor; // factor for generating sampling increment
+	osc_sample sr; // sampling rate
+	osc_sample frequency[OSC_SINELOOPBANK_MAXVOICES];
+	osc_value feedback[OSC_SINELOOPBANK_MAXVOICES]; // in table samples, or Q2.30 in fixed point
+	osc_phase phase[OSC_SINELOOPBANK_MAXVOICES];
+	osc_value last_sample[OSC_SINELOOPBANK_MAXVOICES];
+} osc_sineLoopBank;
+
+void osc_sineLoopBank_init(osc_sineLoopBank *x, osc_sample sr, int nvoices);
+// OSC_PARAM_SAMPLERATE for the bank, OSC_PARAM_PHASE, _FREQUENCY and _FEEDBACK
+// for one voice, or for all of them if voice is -1
+void osc_sineLoopBank_set_param(osc_sineLoopBank *x, int voice, int param, osc_sample value);
+// outputs has a vector per voice, mix gets their sum, either can be 0
+void osc_sineLoopBank_render(osc_sineLoopBank *x, const osc_sample *ratio, osc_sample *const *outputs, osc_sample *mix, int n);
+
+// Wavetable oscillator, reading band-limited mip levels of any single cycle
+// inputs: frequency, phase modulation
+#define OSC_TABOSC_INPUTS 2
+#define OSC_TABOSC_OUTPUTS 1
+typedef struct _osc_wavetable osc_wavetable;
+typedef struct _osc_tabOsc {
+	osc_phase phase;
+	osc_sample si; // sample increment
+	osc_sample sifactor; // factor for generating sampling increment
+	osc_sample sr; // sampling rate
+	const osc_wavetable *table; // the table read, set by the host, 0 renders silence
+} osc_tabOsc;
+
+void osc_tabOsc_init(osc_tabOsc *x, osc_sample sr);
+void osc_tabOsc_set_param(osc_tabOsc *x, int param, osc_sample value);
+void osc_tabOsc_render(osc_tabOsc *x, const osc_sample *const *inputs, osc_sample *const *outputs, int n);
+/* build the mip levels of a cycle of n samples (any length) with FFTs. This is
+   slow and allocates, so run it on any thread but the audio one, and swap the
+   result into osc_tabOsc's table between blocks */
+osc_wavetable *osc_wavetable_new(const osc_sample *cycle, int n);
+void osc_wavetable_free(osc_wavetable *table);
+
+// Generic access to every oscillator, for hosts that pick one by name
+#define OSC_MAX_INPUTS 6 // the most inputs and outputs any oscillator has
+#define OSC_MAX_OUTPUTS 4
+typedef struct _osc_type {
+	const char *name; // the Pd object's name, without the tilde
+	int ninputs, noutputs;
+	const char *const *input_names; // names of the inputs, in order
+	unsigned long size; // size of the state structure
+	void (*init)(void *x, osc_sample sr);
+	void (*set_param)(void *x, int param, osc_sample value);
+	void (*render)(void *x, const osc_sample *const *inputs, osc_sample *const *outputs, int n);
+	// the same oscillator with a render function for vectors that don't overlap at
+	// all, which the compiler can vectorize, or 0 if it has none
+	const struct _osc_type *separate;
+} osc_type;
+
+// all oscillators, terminated by an entry with a null name
+extern const osc_type osc_types[];
+// look an oscillator up by name, returns 0 if there's no such oscillator
+const osc_type *osc_type_find(const char *name);
+// [tabOsc~] isn't in osc_types[], as it renders silence until it's given a table
+extern const osc_type osc_tabOsc_type;
+/* the type to render these vectors with: type->separate if it has one and none
+   of the outputs overlaps an input or another output, type otherwise. Pd hosts
+   call it from the dsp method, as the vectors stay the same until the next one */
+const osc_type *osc_type_select(const osc_type *type, const osc_sample *const *inputs, osc_sample *const *outputs, int n);
+
+// Builds the band-limited tables of [powSine~], or maps them from the cache file
+// left by an earlier run (see libvarious_oscillators.c). They're never built on the
+// audio thread, so bandlimit has no effect until this has been called, or if it
+// failed. The other tables are compiled into the library. Call it before rendering
+void osc_tables_init(void);
+
+/* Decimated (LFO) rendering, for oscillators used as slow modulators. Instead
+   of every sample, the waveform is computed every factor samples and linearly
+   interpolated in between, or once per block and held (factor -1), at a
+   fraction of the cost. The oscillator's own phase accumulator is used, moved
+   factor samples at a time, so frequency and phase resets behave the same */
+typedef struct _osc_decimator {
+	int factor; // 0 renders every sample, -1 once per block
+	int left; // samples left to the next computed point
+	int primed; // the value at the current point is known
+	osc_sample value[OSC_MAX_OUTPUTS], inc[OSC_MAX_OUTPUTS], next[OSC_MAX_OUTPUTS];
+} osc_decimator;
+
+void osc_decimator_init(osc_decimator *d, int factor);
+void osc_decimator_render(osc_decimator *d, const osc_type *type, void *x, const osc_sample *const *inputs, osc_sample *const *outputs, int n);
+
+/* Lock-free event queue, for hosts that send parameter changes from other
+   threads than the audio one (e.g. a GUI or network thread in a libpd host).
+   It's a single producer, single consumer ring: one thread pushes, the audio
+   thread drains it at the start of each block, so neither ever waits on the
+   other and the state is only ever written by the audio thread */
+#define OSC_QUEUE_SIZE 256 // a power of two, with room for a message to every voice of a bank
+
+typedef struct _osc_event {
+	int param; // one of the OSC_PARAM_* values, or a host's own command
+	int offset; // sample of the next block the event applies at, 0 for its start
+	osc_sample value[2]; // the parameter's value, and a second one hosts' commands may use
+} osc_event;
+
+/* The events are kept apart from the indices, wherever the host likes, so the
+   indices can sit with the rest of what's read every block and the events are
+   only touched when there are some */
+typedef struct _osc_queue {
+	unsigned int head; // written by the producer only
+	unsigned int tail; // written by the consumer only
+	osc_event *events; // OSC_QUEUE_SIZE of them
+} osc_queue;
+
+void osc_queue_init(osc_queue *q, osc_event *events);
+// producer side, returns 0 if the queue is full and the event was dropped
+int osc_queue_push(osc_queue *q, const osc_event *event);
+// consumer side, the oldest event or 0 if there's none, then pop it when it's applied
+osc_event *osc_queue_front(osc_queue *q);
+void osc_queue_pop(osc_queue *q);
+/* render a block, applying the queued events at their sample offsets by
+   splitting the block around them. Events with offsets past the block apply
+   at its end, so nothing waits longer than one block. d is optional, if it's
+   given OSC_PARAM_DECIMATE events set it and it renders the block */
+void osc_queue_render(osc_queue *q, const osc_type *type, void *x, osc_decimator *d, const osc_sample *const *inputs, osc_sample *const *outputs, int n);
+
+/* Arena of oscillator states, for hosts running hundreds of oscillators. Each
+   allocated with its owner, their states end up scattered over the heap among
+   colder data, a cache miss or two per oscillator every block. A host places
+   the states in an arena of its own as it builds its DSP chain instead, each
+   at the start of a 64 byte line, in the order they're rendered, so every
+   block reads them from one end of the arena to the other. A state keeps a
+   home in its owner, where it's moved back whenever the arena is filled again
+   or the owner goes away, so wherever it is it stays valid. Always render and
+   set the state the slot points to, never the home. The "state" is best
+   everything the host reads to render a block, the kernel it picked, the
+   queue's indices, the decimator and the oscillator's state, placed before
+   the host hands its address to the chain, so rendering never reads the owner */
+typedef struct _osc_arena osc_arena;
+
+typedef struct _osc_slot {
+	void *state; // where the state is now, the home or a block of the arena
+	void *home; // the owner's own copy
+	unsigned long size;
+	osc_arena *arena; // the arena the state is in, 0 while it's home
+	unsigned long generation; // the arena's filling the state was placed in
+	struct _osc_slot *prev, *next; // the states in the arena
+} osc_slot;
+
+osc_arena *osc_arena_new(void);
+// moves every state still in the arena home first
+void osc_arena_free(osc_arena *arena);
+/* the arena of a host, made the first time it's asked for, for hosts that
+   have nowhere to keep one: the Pd objects pass pd_this, so every Pd instance
+   libpd runs gets its own. It's never freed, but its memory is once it's empty */
+osc_arena *osc_arena_of(const void *host);
+
+// the state starts at home, initialize it there first
+void osc_slot_init(osc_slot *slot, void *home, unsigned long size);
+/* move the state to the end of the arena (0 leaves it home). Placements at
+   another time than the last one (Pd's logical time) belong to a new DSP
+   chain, and start the arena over after moving every state in it home. A
+   chain built again at the same time leaves the states already placed where
+   they are, so a state never moves while a chain built at that time renders
+   it. Call it from the thread building the host's chain, while nothing's
+   being rendered or pushed to the states' queues */
+void osc_slot_place(osc_arena *arena, osc_slot *slot, double time);
+// move the state home for good, before its owner is freed
+void osc_slot_release(osc_slot *slot);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // VARIOUS_OSCILLATORS_H